@@ -186,12 +186,151 @@ or EMI triggering the related interrupt falsely or too many times.
 #define DEBOUNCE_DELAY 40 // ms
 #endif
 
+/*! \def CRC_SLICE_BY
+\brief
+Selects the CRC-16 implementation used for settings checksums, binary realtime reports and Modbus RTU messages:
++ `0` - bitwise, no tables.
++ `1` - table driven, 512 bytes of tables per CRC.
++ `4` - slicing-by-4, 2 KB of tables per CRC.
++ `8` - slicing-by-8, 4 KB of tables per CRC.
+
+The default, table driven, costs 1 KB of flash for the two CRCs and makes \a modbus_crc16x() more than four times
+as fast as the bitwise implementation, see the \a bench_crc tests of the host simulator. Set to 0 for flash
+constrained targets, 4 or 8 only pays off for long messages.
+*/
+#if !defined CRC_SLICE_BY || defined __DOXYGEN__
+#define CRC_SLICE_BY 1
+#endif
+
 // ---------------------------------------------------------------------------------------
 // ADVANCED CONFIGURATION OPTIONS:
 
 // EXPERIMENTAL OPTIONS
 
-#define ENABLE_PATH_BLENDING Off // Do NOT enable unless working on adding this feature!
+/*! \def ENABLE_PATH_BLENDING
+\brief Enable to add support for G61, G61.1 and G64 P path control modes.
+When G64 P<tolerance> is active the planner cuts corners between consecutive feed moves by inserting
+a chord that deviates no more than the tolerance from the programmed path, this keeps the feed rate up
+through CAM generated polylines. G64 without P keeps the junction deviation based behaviour.
+When line merging is enabled the Q word sets the tolerance used for merging collinear moves,
+see \ref ENABLE_LINE_MERGING.
+*/
+#if !defined ENABLE_PATH_BLENDING || defined __DOXYGEN__
+#define ENABLE_PATH_BLENDING Off
+#endif
+
+/*! \def ENABLE_LINE_MERGING
+\brief Enable to merge collinear feed moves into the last block in the planner buffer.
+CAM output often splits straight runs into many short moves, merging them extends the look-ahead
+distance of the planner. Moves are only merged in G64 mode, when \ref ENABLE_PATH_BLENDING is not enabled
+G64 is accepted without P and Q words. A move is merged when it continues in the same direction, deviates
+no more than \ref LINE_MERGE_TOLERANCE from the path and has the same feed rate, spindle state and overrides.
+The line number reported is that of the last move merged.
+*/
+#if !defined ENABLE_LINE_MERGING || defined __DOXYGEN__
+#define ENABLE_LINE_MERGING Off
+#endif
+
+/*! \def LINE_MERGE_TOLERANCE
+\brief Maximum deviation from the programmed path in mm allowed when merging collinear moves.
+Overridden by G64 Q<tolerance> when \ref ENABLE_PATH_BLENDING is enabled.
+*/
+#if !defined LINE_MERGE_TOLERANCE || defined __DOXYGEN__
+#define LINE_MERGE_TOLERANCE 0.002f // mm
+#endif
+
+/*! \def PLANNER_RECALC_BUDGET
+\brief Maximum number of blocks the planner reverse pass processes each time a block is added, 0 for no limit.
+With large planner buffers and short segments the reverse pass may walk most of the buffer, delaying
+the segment generator. When the limit is reached the pass resumes on the next call, blocks not yet
+replanned keep their earlier planned entry speeds which are lower, but always safe.
+*/
+#if !defined PLANNER_RECALC_BUDGET || defined __DOXYGEN__
+#define PLANNER_RECALC_BUDGET 0
+#endif
+
+/*! \def PLANNER_RECALC_STATS
+\brief Enable to collect statistics for the number of blocks processed by the planner per block added.
+Output by the <i>$PLANNERSTATS</i> command.
+*/
+#if !defined PLANNER_RECALC_STATS || defined __DOXYGEN__
+#define PLANNER_RECALC_STATS Off
+#endif
+
+/*! \def ENABLE_AXIS_JUNCTION_LIMITS
+\brief Enable to limit junction speeds by the velocity change each axis can make instead of by junction deviation.
+The velocity change allowed for an axis is that of a jerk limited acceleration ramp up to its max acceleration and
+back to zero, acceleration squared divided by jerk. This allows faster cornering for axes with high acceleration
+and jerk settings, such as a light gantry, while limiting corner speeds where a heavy axis changes direction.
+The junction deviation setting is only used for junctions where an axis with a jerk setting of zero changes velocity.
+__NOTE:__ axis jerk settings are only available when \ref ENABLE_JERK_ACCELERATION is enabled, default values are used if not.
+*/
+#if !defined ENABLE_AXIS_JUNCTION_LIMITS || defined __DOXYGEN__
+#define ENABLE_AXIS_JUNCTION_LIMITS Off
+#endif
+
+/*! \def ENABLE_ADAPTIVE_ARC_TOLERANCE
+\brief Enable to increase arc segment length above what the arc tolerance setting gives when needed to keep
+the planner look-ahead distance at or above the stopping distance from the achievable arc feed rate.
+Large radius arcs with a fine arc tolerance will then not be starved of feed rate by a planner buffer filled
+with tiny segments, small radius arcs are limited by the junction speed between segments and are not affected.
+Segment length is limited by \ref ARC_MAX_TOLERANCE and by an angle of 0.25 radians per segment.
+*/
+#if !defined ENABLE_ADAPTIVE_ARC_TOLERANCE || defined __DOXYGEN__
+#define ENABLE_ADAPTIVE_ARC_TOLERANCE Off
+#endif
+
+/*! \def ENABLE_NATIVE_ARCS
+\brief Enable to execute G2/G3 arcs as a single planner block, the segment generator then computes
+each step segment end point on the true arc. This frees the planner look-ahead for the surrounding moves,
+removes the junction slowdowns between arc segments and the need for \ref N_ARC_CORRECTION.
+Arc feed rate is limited by the centripetal acceleration the arc plane axes can handle.
+__NOTE:__ increases the planner block size, not available with kinematics or backlash compensation.
+*/
+#if !defined ENABLE_NATIVE_ARCS || defined __DOXYGEN__
+#define ENABLE_NATIVE_ARCS Off
+#endif
+
+/*! \def ENABLE_SEGMENT_RATE_INTERPOLATION
+\brief Enable to ramp the step rate linearly from the segment start to end speed within each step segment
+instead of stepping at a constant rate. This removes the staircase step rate profile during acceleration and
+deceleration, allowing a lower \ref ACCELERATION_TICKS_PER_SECOND value to reduce foreground processing.
+Adds a timer reload for each step. Not used for spindle synchronized motion and at very low step rates.
+*/
+#if !defined ENABLE_SEGMENT_RATE_INTERPOLATION || defined __DOXYGEN__
+#define ENABLE_SEGMENT_RATE_INTERPOLATION Off
+#endif
+
+/*! \def CRUISE_SEGMENT_MULTIPLIER
+\brief Maximum step segment time when cruising, as a multiple of the normal segment time given by
+\ref ACCELERATION_TICKS_PER_SECOND. Longer segments reduce foreground processing and the risk of segment buffer
+underruns on heavily loaded controllers. The response time to feed holds and overrides is increased by up to
+the time of the cruise segments in the segment buffer. Set to 1 to disable.
+__NOTE:__ segments are limited to 65535 steps, or less when AMASS is enabled.
+*/
+#if !defined CRUISE_SEGMENT_MULTIPLIER || defined __DOXYGEN__
+#define CRUISE_SEGMENT_MULTIPLIER 1
+#endif
+
+/*! \def STEP_BATCH_SIZE
+\brief Maximum number of step events in a batch of step pulses for drivers that clock out step and direction
+signals by DMA, set to 0 to disable. Batches are only used if the driver provides the optional
+\a hal.stepper.output_batch handler, the step interrupt handler is then called once per batch instead of once
+per step. Batches are limited to a single step event during homing and probing.
+Spindle and laser power updates lead the step output by up to two batches, keep batches short for laser mode.
+__NOTE:__ not available with spindle synchronized motion.
+*/
+#if !defined STEP_BATCH_SIZE || defined __DOXYGEN__
+#define STEP_BATCH_SIZE 0
+#endif
+
+/*! \def ARC_MAX_TOLERANCE
+\brief Maximum deviation from the true arc when \ref ENABLE_ADAPTIVE_ARC_TOLERANCE is enabled, in mm.
+The arc tolerance setting is used instead if larger.
+*/
+#if !defined ARC_MAX_TOLERANCE || defined __DOXYGEN__
+#define ARC_MAX_TOLERANCE 0.01f // mm
+#endif
 
 #if !defined ENABLE_ACCELERATION_PROFILES || defined __DOXYGEN__
 #define ENABLE_ACCELERATION_PROFILES Off // Enable to allow G-Code changeable acceleration profiles.
@@ -231,6 +370,9 @@ to be refreshed very often, on the order of a several seconds.
 #if !defined REPORT_WCO_REFRESH_IDLE_COUNT || defined __DOXYGEN__
 #define REPORT_WCO_REFRESH_IDLE_COUNT 10        // (2-255) Must be less than or equal to the busy count
 #endif
+#if !defined REPORT_DELTA_KEYFRAME_INTERVAL || defined __DOXYGEN__
+#define REPORT_DELTA_KEYFRAME_INTERVAL 20       // (1-255) Number of delta reports between full reports, see #DEFAULT_REPORT_DELTA.
+#endif
 ///@}
 
 /*! \def ACCELERATION_TICKS_PER_SECOND
@@ -343,6 +485,16 @@ much greater than this. The default setting should capture most, if not all, ful
 #endif
 ///@}
 
+/*! \def ENABLE_ADAPTIVE_SPLINES
+\brief Enable to subdivide G5 and G5.1 splines from the local curvature of the curve, chords are then
+kept within the arc tolerance setting from the curve and the feed rate is limited by the centripetal
+acceleration at the local curvature radius. Parameter steps are limited by \ref BEZIER_MIN_STEP and
+\ref BEZIER_MAX_STEP, \ref BEZIER_SIGMA is not used.
+*/
+#if !defined ENABLE_ADAPTIVE_SPLINES || defined __DOXYGEN__
+#define ENABLE_ADAPTIVE_SPLINES Off
+#endif
+
 
 /*! \def DWELL_TIME_STEP
 \brief Time delay increments performed during a dwell.
@@ -559,6 +711,19 @@ Maximum number of parameters allowed in a block.
 #define NGC_N_ASSIGN_PARAMETERS_PER_BLOCK 10
 #endif
 
+/*! \def NGC_MACRO_CACHE_SIZE
+\brief
+Maximum number of bytes of named subroutine macro files kept in RAM, set to 0 to disable the cache.
+Cached macros are served from RAM on subsequent calls, files larger than this are read from the
+file system on each call. Cached content is invalidated when the file system is changed or,
+for files on hidden mounts, when the file size has changed.
+
+_NOTE:_ the cache is allocated from the heap as macros are loaded.
+*/
+#if !defined NGC_MACRO_CACHE_SIZE || defined __DOXYGEN__
+#define NGC_MACRO_CACHE_SIZE 0
+#endif
+
 /*! \def LATHE_UVW_OPTION
 \brief
 Allow use of UVW axis words for non-modal relative lathe motion.
@@ -728,6 +893,19 @@ Enabling this setting enables status reporting while homing.
 #define DEFAULT_REPORT_WHEN_HOMING Off // Default off. Set to \ref On or 1 to enable.
 #endif
 
+/*! \def DEFAULT_REPORT_DELTA
+\brief
+Enabling this setting makes the real time report omit the position, buffer state, line number,
+feed & speed and pin state fields if unchanged since last sent to the connection.
+A field that is no longer present is sent once with an empty value, e.g. `|Pn:`.
+A full report is sent every #REPORT_DELTA_KEYFRAME_INTERVAL reports and when requested by `0x87`.
+<br>__NOTE:__ Enabling this option will break senders not supporting it.
+\internal Bit 13 in settings.status_report.
+*/
+#if !defined DEFAULT_REPORT_DELTA || defined __DOXYGEN__
+#define DEFAULT_REPORT_DELTA Off // Default off. Set to \ref On or 1 to enable.
+#endif
+
 ///@}
 
 /*! @name $11 - Setting_JunctionDeviation
@@ -2263,6 +2441,10 @@ __NOTE:__ Must be a positive values.
 #error "Cannot enable laser and lathe mode at the same time!"
 #endif
 
+#if ENABLE_NATIVE_ARCS && ENABLE_BACKLASH_COMPENSATION
+#error "Cannot enable native arcs and backlash compensation at the same time!"
+#endif
+
 #if LATHE_UVW_OPTION && (N_AXIS > 6 || AXIS_REMAP_ABC2UVW)
 #warning "Cannot enable lathe UVW option when N_AXIS > 6 or ABC words are remapped!"
 #undef LATHE_UVW_OPTION
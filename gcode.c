@@ -1218,10 +1218,10 @@ status_code_t gc_execute_block (char *block)
                         }
                         break;
 
-#if ENABLE_PATH_BLENDING
+#if ENABLE_PATH_BLENDING || ENABLE_LINE_MERGING
                     case 61:
                         word_bit.modal_group.G13 = On;
-                        if (mantissa != 0 || mantissa != 10)
+                        if (mantissa != 0 && mantissa != 10)
                             FAIL(Status_GcodeUnsupportedCommand);
                         gc_block.modal.control = mantissa == 0 ? ControlMode_ExactPath : ControlMode_ExactStop;
                         break;
@@ -3595,7 +3595,7 @@ status_code_t gc_execute_block (char *block)
 
     // [16. Set path control mode ]: G61.1/G64 NOT SUPPORTED
     // gc_state.modal.control = gc_block.modal.control; // NOTE: Always default.
-#if ENABLE_PATH_BLENDING
+#if ENABLE_PATH_BLENDING || ENABLE_LINE_MERGING
     gc_state.modal.control = gc_block.modal.control;
 #endif
 
@@ -3748,6 +3748,9 @@ status_code_t gc_execute_block (char *block)
 #if ENABLE_PATH_BLENDING
         plan_data.cam_tolerance = gc_state.cam_tolerance;
         plan_data.path_tolerance = gc_state.path_tolerance;
+#endif
+#if ENABLE_LINE_MERGING
+        plan_data.control = gc_state.modal.control;
 #endif
         pos_update_t gc_update_pos = GCUpdatePos_Target;
 
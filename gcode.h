@@ -541,8 +541,8 @@ typedef struct {
     //< uint8_t cutter_comp;             //!< {G40} NOTE: Don't track. Only default supported.
     tool_offset_mode_t tool_offset_mode; //!< {G43,G43.1,G49}
     coord_system_t coord_system;         //!< {G54,G55,G56,G57,G58,G59,G59.1,G59.2,G59.3}
-#if ENABLE_PATH_BLENDING
-    control_mode_t control;              //!< {G61} NOTE: Don't track. Only default supported.
+#if ENABLE_PATH_BLENDING || ENABLE_LINE_MERGING
+    control_mode_t control;              //!< {G61,G61.1,G64}
 #endif
     program_flow_t program_flow;         //!< {M0,M1,M2,M30,M60}
     coolant_state_t coolant;             //!< {M7,M8,M9}
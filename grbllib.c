@@ -258,6 +258,11 @@ int grbl_enter (void)
 
     driver.init = driver_init();
 
+#if STEP_BATCH_SIZE
+    if(hal.stepper.output_batch)
+        hal.stepper.interrupt_callback = stepper_batch_interrupt_handler;
+#endif
+
 #ifdef DEBUGOUT
     debug_stream_init();
 #endif
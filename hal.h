@@ -327,6 +327,31 @@ To be called by the driver from the main stepper interrupt handler (when the tim
 */
 typedef void (*stepper_interrupt_callback_ptr)(void);
 
+#if STEP_BATCH_SIZE
+
+/*! \brief Pointer to function for outputting a batch of step events, by DMA or similar.
+
+When provided \ref stepper_ptrs_t.interrupt_callback fills a batch of step events and passes it to this function,
+the driver should call it when started, whenever it has no batch queued after the one being output and when
+output of a batch is complete with no batch queued. When there are no more step events it returns without passing
+a batch, and without going idle if a batch passed may still be output. Output must thus continue until
+\ref stepper_ptrs_t.go_idle is called, which happens from the call made when output of the last batch is complete.
+Two batch buffers are used alternately, a batch is overwritten when \ref stepper_ptrs_t.interrupt_callback
+is called for the batch after the next. The driver must thus be done with, or have copied, the batch being output
+before calling it while the next batch is queued.
+\ref stepper_ptrs_t.pulse_start and \ref stepper_ptrs_t.cycles_per_tick are not called when batches are output,
+the step timing is passed in each step event.
+
+__NOTE:__ spindle and laser power updates are made when a batch is filled, and thus lead the step output by up to two batches.
+
+\param batch pointer to a \ref step_batch_t struct containing the step events to output.
+
+__NOTE:__ this function will be called from an interrupt context.
+*/
+typedef void (*stepper_output_batch_ptr)(step_batch_t *batch);
+
+#endif
+
 //! Stepper motor handlers
 typedef struct {
     stepper_wake_up_ptr wake_up;                        //!< Handler for enabling stepper motor power and main stepper interrupt.
@@ -341,6 +366,9 @@ typedef struct {
     stepper_output_step_ptr output_step;                //!< Optional handler for outputting a single step pulse. _Experimental._ Called from interrupt context.
     motor_iterator_ptr motor_iterator;                  //!< Optional handler iteration over motor vs. axis mappings. Required for the motors plugin (Trinamic drivers).
     stepper_status_ptr status;                          //!< Optional handler handler for querying steppper driver status or attempting to reset it.
+#if STEP_BATCH_SIZE
+    stepper_output_batch_ptr output_batch;              //!< Optional handler for outputting a batch of step events. Called from interrupt context.
+#endif
 } stepper_ptrs_t;
 
 
@@ -166,10 +166,15 @@ bool mc_line (float *target, plan_line_data_t *pl_data)
 
         // If the buffer is full: good! That means we are well ahead of the robot.
         // Remain in this loop until there is room in the buffer.
+        // Blended corners add two blocks, wait for room for both.
          do {
             if(!protocol_execute_realtime())    // Check for any run-time commands
                 return false;                   // Bail, if system abort.
+#if ENABLE_PATH_BLENDING
+            if(pl_data->path_tolerance > 0.0f ? plan_get_block_buffer_available() < 3 : plan_check_full_buffer())
+#else
             if(plan_check_full_buffer())
+#endif
                 protocol_auto_cycle_start();    // Auto-cycle start when buffer is full.
             else
                 break;
@@ -210,6 +215,43 @@ bool mc_line (float *target, plan_line_data_t *pl_data)
 // The arc is approximated by generating a huge number of tiny, linear segments. The chordal tolerance
 // of each segment is configured in settings.arc_tolerance, which is defined to be the maximum normal
 // distance from segment to the circle when the end points both lie on the circle.
+#if ENABLE_ADAPTIVE_ARC_TOLERANCE
+
+// Returns the number of segments for an arc. The segment length given by the arc tolerance setting is increased
+// when the planner look-ahead filled with arc segments would be shorter than the stopping distance from the
+// achievable feed rate. The planner limits the speed at the junctions between segments by junction deviation,
+// v^2 = 8 * a * junction_deviation * r^2 / chord^2, look-ahead chords that are long enough for either this or
+// the programmed feed rate are used. The chords for the junction speed are shortened by 20%, longer chords
+// raise the axis accelerations at the junctions above those of the unmodified chords without reducing the cycle time.
+// NOTE: Only arcs with a large radius relative to the arc tolerance and the planner buffer size are affected,
+//       small radius arcs are limited by the junction speed and not by the look-ahead.
+static uint_fast16_t arc_segments (float arc_length, float radius, plane_t plane, plan_line_data_t *pl_data)
+{
+    float chord = 2.0f * sqrtf(settings.arc_tolerance * (2.0f * radius - settings.arc_tolerance));
+
+    if(!pl_data->condition.inverse_time) {
+
+        float acceleration = min(settings.axis[plane.axis_0].acceleration, settings.axis[plane.axis_1].acceleration);
+        float feed_rate = pl_data->feed_rate * (float)sys.override.feed_rate * 0.01f;
+
+        feed_rate = min(feed_rate, min(settings.axis[plane.axis_0].max_rate, settings.axis[plane.axis_1].max_rate));
+
+        float n_blocks = (float)plan_get_buffer_size();
+        float lookahead_chord = min(feed_rate * feed_rate / (2.0f * acceleration * n_blocks),
+                                     0.8f * cbrtf(4.0f * settings.junction_deviation * radius * radius / n_blocks));
+
+        if(lookahead_chord > chord) {
+            float max_tolerance = min(max(ARC_MAX_TOLERANCE, settings.arc_tolerance), radius);
+            lookahead_chord = min(lookahead_chord, 2.0f * sqrtf(max_tolerance * (2.0f * radius - max_tolerance)));
+            chord = max(chord, min(lookahead_chord, 0.25f * radius)); // Keep within range of the small angle approximation.
+        }
+    }
+
+    return (uint_fast16_t)floorf(arc_length / chord);
+}
+
+#endif
+
 void mc_arc (float *target, plan_line_data_t *pl_data, float *position, float *offset, float radius, plane_t plane, int32_t turns)
 {
     typedef union {
@@ -287,6 +329,35 @@ void mc_arc (float *target, plan_line_data_t *pl_data, float *position, float *o
         }
     }
 
+#if ENABLE_NATIVE_ARCS && !defined(KINEMATICS_API)
+
+    // Queue the arc as a single planner block, the segment generator computes the step segments along the arc.
+    if(2.0f * radius > settings.arc_tolerance) {
+
+        plan_arc_t arc = {
+            .center[0] = (float)center.x,
+            .center[1] = (float)center.y,
+            .radius_vec[0] = (float)rv.x,
+            .radius_vec[1] = (float)rv.y,
+            .radius = (float)hypot(rv.x, rv.y),
+            .angular_travel = angular_travel,
+            .axis_0 = plane.axis_0,
+            .axis_1 = plane.axis_1
+        };
+
+        pl_data->arc = &arc;
+        pl_data->condition.arc_motion = On;
+
+        mc_line(target, pl_data);
+
+        pl_data->condition.arc_motion = Off;
+        pl_data->arc = NULL;
+
+        return;
+    }
+
+#endif
+
     // NOTE: Segment end points are on the arc, which can lead to the arc diameter being smaller by up to
     // (2x) settings.arc_tolerance. For 99% of users, this is just fine. If a different arc segment fit
     // is desired, i.e. least-squares, midpoint on arc, just change the mm_per_arc_segment calculation.
@@ -295,7 +366,11 @@ void mc_arc (float *target, plan_line_data_t *pl_data, float *position, float *o
     uint_fast16_t segments = 0;
 
     if(2.0f * radius > settings.arc_tolerance)
+#if ENABLE_ADAPTIVE_ARC_TOLERANCE
+        segments = arc_segments(fabsf(angular_travel * radius), radius, plane, pl_data);
+#else
         segments = (uint_fast16_t)floorf(fabsf(0.5f * angular_travel * radius) / sqrtf(settings.arc_tolerance * (2.0f * radius - settings.arc_tolerance)));
+#endif
 
     if(segments) {
 
@@ -473,6 +548,84 @@ static inline float dist1 (const float x1, const float y1, const float x2, const
  * power available on Arduino, I think it is not wise to implement it.
  */
 
+#if ENABLE_ADAPTIVE_SPLINES
+
+// Computes the first and second derivative of a cubic Bézier curve.
+static inline void bezier_derivatives (const float a, const float b, const float c, const float d, const float t, float *d1, float *d2)
+{
+    const float u = 1.0f - t;
+
+    *d1 = 3.0f * (u * u * (b - a) + 2.0f * u * t * (c - b) + t * t * (d - c));
+    *d2 = 6.0f * (u * (c - 2.0f * b + a) + t * (d - 2.0f * c + b));
+}
+
+// Returns the parameter step giving a chord with the arc tolerance deviation from the curve
+// at the local curvature radius at t, the radius is returned in *radius.
+static float bezier_step (float *target, float *position, float *first, float *second, const float t, float *radius)
+{
+    float dx, dy, ddx, ddy, speed, cross, chord;
+
+    bezier_derivatives(position[X_AXIS], first[X_AXIS], second[X_AXIS], target[X_AXIS], t, &dx, &ddx);
+    bezier_derivatives(position[Y_AXIS], first[Y_AXIS], second[Y_AXIS], target[Y_AXIS], t, &dy, &ddy);
+
+    speed = sqrtf(dx * dx + dy * dy); // Curve length per unit of t
+    cross = fabsf(dx * ddy - dy * ddx);
+    *radius = cross > 0.0f ? speed * speed * speed / cross : SOME_LARGE_VALUE;
+
+    if(speed == 0.0f)
+        return BEZIER_MIN_STEP;
+
+    chord = *radius > settings.arc_tolerance
+             ? 2.0f * sqrtf(settings.arc_tolerance * (2.0f * *radius - settings.arc_tolerance))
+             : 2.0f * *radius;
+
+    return min(max(chord / speed, BEZIER_MIN_STEP), BEZIER_MAX_STEP);
+}
+
+/*
+ * The parameter step is computed from the local curvature of the curve such that the deviation of
+ * each chord from the curve is within the arc tolerance setting, the curvature is checked at both
+ * ends of the chord. The rate of each chord is limited by the centripetal acceleration the
+ * X and Y axes can handle at the local curvature radius, also when feed override is active.
+ */
+void mc_cubic_b_spline (float *target, plan_line_data_t *pl_data, float *position, float *first, float *second)
+{
+    float bez_target[N_AXIS], t = 0.0f, step, radius, end_radius;
+    float acceleration = min(settings.axis[X_AXIS].acceleration, settings.axis[Y_AXIS].acceleration);
+
+#if ENABLE_ACCELERATION_PROFILES
+    acceleration *= pl_data->acceleration_factor;
+#endif
+
+    memcpy(bez_target, position, sizeof(float) * N_AXIS);
+
+    while(t < 1.0f) {
+
+        step = bezier_step(target, position, first, second, t, &radius);
+        if(t + step < 1.0f) {
+            step = min(step, bezier_step(target, position, first, second, t + step, &end_radius));
+            radius = min(radius, end_radius);
+        }
+
+        if((t += step) > 1.0f)
+            t = 1.0f;
+
+        bez_target[X_AXIS] = eval_bezier(position[X_AXIS], first[X_AXIS], second[X_AXIS], target[X_AXIS], t);
+        bez_target[Y_AXIS] = eval_bezier(position[Y_AXIS], first[Y_AXIS], second[Y_AXIS], target[Y_AXIS], t);
+
+        // Limit the rate of the chord, the limit is not subject to feed overrides.
+        pl_data->max_rate = max(sqrtf(acceleration * radius), MINIMUM_FEED_RATE);
+
+        // Bail mid-spline on system abort. Runtime command check already performed by mc_line.
+        if(!mc_line(bez_target, pl_data))
+            break;
+    }
+
+    pl_data->max_rate = 0.0f;
+}
+
+#else
+
 void mc_cubic_b_spline (float *target, plan_line_data_t *pl_data, float *position, float *first, float *second)
 {
     float bez_target[N_AXIS];
@@ -561,6 +714,8 @@ void mc_cubic_b_spline (float *target, plan_line_data_t *pl_data, float *positio
     }
 }
 
+#endif // ENABLE_ADAPTIVE_SPLINES
+
 // end Bezier splines
 
 void mc_canned_drill (motion_mode_t motion, float *target, plan_line_data_t *pl_data, float *position, plane_t plane, uint32_t repeats, gc_canned_t *canned)
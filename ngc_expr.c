@@ -930,6 +930,385 @@ status_code_t ngc_eval_expression (char *line, uint_fast8_t *pos, float *value)
     return Status_OK;
 }
 
+/*
+ * Expression compiler, produces postfix bytecode that can be evaluated
+ * repeatedly without parsing the expression text.
+ */
+
+#define MAX_CODE_SIZE 256
+#define MAX_EVAL_STACK 16
+
+typedef enum {
+    NGCOp_End = 0,
+    NGCOp_Push,         // Push constant, float operand follows
+    NGCOp_Check,        // Fail if top of stack is not a number or infinite
+    NGCOp_Integer,      // Fail if top of stack is not an integer, round it if close
+    NGCOp_Negate,       // Negate top of stack
+    NGCOp_Param,        // Pop id, push value of numbered parameter
+    NGCOp_NamedParam,   // Push value of named parameter, zero terminated name follows
+    NGCOp_Exists,       // Push 1.0 if named parameter exists, 0.0 if not, zero terminated name follows
+    NGCOp_Setting,      // Pop setting id, push setting value
+    NGCOp_SettingBit,   // Pop bit number and setting id, push setting value bit
+    NGCOp_Atan,         // Pop two values, push atan2 result
+    NGCOp_Unary,        // Execute unary operation on top of stack, ngc_unary_op_t operand follows
+    NGCOp_Binary        // Pop two values, push binary operation result, ngc_binary_op_t operand follows
+} ngc_opcode_t;
+
+struct ngc_expr {
+    uint8_t length;     // Number of characters in the expression text.
+    uint8_t depth;      // Maximum evaluation stack depth.
+    uint8_t code[];
+};
+
+typedef struct {
+    uint8_t *code;
+    uint_fast16_t size;
+    uint_fast8_t depth;
+    uint_fast8_t max_depth;
+} ngc_compiler_t;
+
+static status_code_t compile_expression (ngc_compiler_t *cc, char *line, uint_fast8_t *pos);
+
+static status_code_t emit (ngc_compiler_t *cc, const void *data, uint_fast8_t size, int_fast8_t stack_change)
+{
+    if(cc->size + size > MAX_CODE_SIZE)
+        return Status_ExpressionSyntaxError;
+
+    memcpy(cc->code + cc->size, data, size);
+    cc->size += size;
+
+    if((cc->depth += stack_change) > cc->max_depth)
+        cc->max_depth = cc->depth;
+
+    return cc->max_depth > MAX_EVAL_STACK ? Status_ExpressionSyntaxError : Status_OK;
+}
+
+static status_code_t emit_op (ngc_compiler_t *cc, ngc_opcode_t opcode, int_fast8_t stack_change)
+{
+    uint8_t op = (uint8_t)opcode;
+
+    return emit(cc, &op, 1, stack_change);
+}
+
+static status_code_t emit_op_arg (ngc_compiler_t *cc, ngc_opcode_t opcode, uint8_t arg, int_fast8_t stack_change)
+{
+    uint8_t op[2] = { (uint8_t)opcode, arg };
+
+    return emit(cc, op, 2, stack_change);
+}
+
+static status_code_t emit_name (ngc_compiler_t *cc, ngc_opcode_t opcode, char *name, size_t len)
+{
+    status_code_t status;
+    uint8_t nul = 0;
+
+    if((status = emit_op(cc, opcode, 1)) == Status_OK && (status = emit(cc, name, len, 0)) == Status_OK)
+        status = emit(cc, &nul, 1, 0);
+
+    return status;
+}
+
+// Compiles a value, see ngc_read_real_value() for details.
+static status_code_t compile_real_value (ngc_compiler_t *cc, char *line, uint_fast8_t *pos)
+{
+    char c = line[*pos], c1;
+
+    if(c == '\0')
+        return Status_ExpressionSyntaxError;
+
+    status_code_t status;
+
+    c1 = line[*pos + 1];
+
+    if(c == '[')
+        status = compile_expression(cc, line, pos);
+
+    else if(c == '#') {
+
+        (*pos)++;
+
+        if(line[*pos] == '<') {
+
+            char name[NGC_MAX_PARAM_LENGTH + 1];
+
+            if((status = ngc_read_name(line, pos, name)) == Status_OK)
+                status = emit_name(cc, NGCOp_NamedParam, name, strlen(name));
+
+        } else if((status = compile_real_value(cc, line, pos)) == Status_OK &&
+                   (status = emit_op(cc, NGCOp_Integer, 0)) == Status_OK)
+            status = emit_op(cc, NGCOp_Param, 0);
+
+    } else if(c == '+' && c1 && !isdigit(c1) && c1 != '.') {
+        (*pos)++;
+        status = compile_real_value(cc, line, pos);
+    } else if(c == '-' && c1 && !isdigit(c1) && c1 != '.') {
+        (*pos)++;
+        if((status = compile_real_value(cc, line, pos)) == Status_OK)
+            status = emit_op(cc, NGCOp_Negate, 0);
+
+    } else if ((c >= 'A') && (c <= 'Z')) {
+
+        ngc_unary_op_t operation;
+
+        if((status = read_operation_unary(line, pos, &operation)) != Status_OK)
+            return status;
+
+        if(line[*pos] != '[')
+            return Status_ExpressionSyntaxError;
+
+        if(operation == NGCUnaryOp_Exists) {
+
+            char *arg = &line[++(*pos)], *s = NULL;
+
+            if(*arg == '#' && *(arg + 1) == '<') {
+                arg += 2;
+                s = arg;
+                while(*s && *s != ']')
+                    s++;
+            }
+
+            if(s && *s == ']' && *(s - 1) == '>' && s - arg - 1 <= NGC_MAX_PARAM_LENGTH) {
+                status = emit_name(cc, NGCOp_Exists, arg, s - arg - 1);
+                *pos = *pos + s - arg + 3;
+            } else
+                status = Status_ExpressionSyntaxError;
+
+        } else if(operation == NGCUnaryOp_Parameter) {
+
+            bool get_bit;
+
+            (*pos)++;
+            if((status = compile_real_value(cc, line, pos)) != Status_OK || (status = emit_op(cc, NGCOp_Integer, 0)) != Status_OK)
+                return status;
+
+            if((get_bit = line[*pos] == ',')) {
+                (*pos)++;
+                if((status = compile_real_value(cc, line, pos)) != Status_OK || (status = emit_op(cc, NGCOp_Integer, 0)) != Status_OK)
+                    return status;
+            }
+
+            if(line[*pos] != ']')
+                return Status_ExpressionSyntaxError;
+
+            (*pos)++;
+
+            status = get_bit ? emit_op(cc, NGCOp_SettingBit, -1) : emit_op(cc, NGCOp_Setting, 0);
+
+        } else if((status = compile_expression(cc, line, pos)) == Status_OK) {
+
+            if(operation == NGCUnaryOp_ATAN) {
+
+                if(line[*pos] != '/' || line[*pos + 1] != '[')
+                    return Status_ExpressionSyntaxError;
+
+                (*pos)++;
+
+                if((status = compile_expression(cc, line, pos)) == Status_OK)
+                    status = emit_op(cc, NGCOp_Atan, -1);
+            } else
+                status = emit_op_arg(cc, NGCOp_Unary, (uint8_t)operation, 0);
+        }
+
+    } else {
+
+        float value;
+
+        if(read_float(line, pos, &value)) {
+            if((status = emit_op(cc, NGCOp_Push, 1)) == Status_OK)
+                status = emit(cc, &value, sizeof(float), 0);
+        } else
+            status = Status_BadNumberFormat;
+    }
+
+    if(status == Status_OK)
+        status = emit_op(cc, NGCOp_Check, 0);
+
+    return status;
+}
+
+// Compiles a bracketed expression, see ngc_eval_expression() for details.
+// Operators are emitted in the same order as they are executed by ngc_eval_expression().
+static status_code_t compile_expression (ngc_compiler_t *cc, char *line, uint_fast8_t *pos)
+{
+    ngc_binary_op_t operation, operators[MAX_STACK];
+    uint_fast8_t stack_index = 0;
+    status_code_t status;
+
+    if(line[*pos] != '[')
+        return Status_GcodeUnsupportedCommand;
+
+    (*pos)++;
+
+    do {
+
+        if((status = compile_real_value(cc, line, pos)) != Status_OK)
+            return status;
+
+        if((status = read_operation(line, pos, &operation)) != Status_OK)
+            return status;
+
+        while(stack_index && precedence(operators[stack_index - 1]) >= precedence(operation)) {
+            if((status = emit_op_arg(cc, NGCOp_Binary, (uint8_t)operators[--stack_index], -1)) != Status_OK)
+                return status;
+        }
+
+        if(operation != NGCBinaryOp_RightBracket) {
+            if(stack_index == MAX_STACK)
+                return Status_ExpressionSyntaxError;
+            operators[stack_index++] = operation;
+        }
+
+    } while(operation != NGCBinaryOp_RightBracket);
+
+    return Status_OK;
+}
+
+/*! \brief Compile expression to bytecode for repeated evaluation by ngc_exec_expression().
+
+_NOTE:_ The returned object must be freed by the caller.
+
+\param line pointer to RS274/NGC code (block).
+\param pos offset into line where expression starts, on success updated to the end of the expression.
+\returns pointer to the compiled expression on success, NULL if out of memory or on failure.
+Use ngc_eval_expression() to get the status code on failure.
+*/
+ngc_expr_t *ngc_compile_expression (char *line, uint_fast8_t *pos)
+{
+    uint8_t code[MAX_CODE_SIZE];
+    uint_fast8_t start = *pos, end = *pos;
+    ngc_expr_t *expr = NULL;
+    ngc_compiler_t cc = {
+        .code = code
+    };
+
+    if(compile_expression(&cc, line, &end) == Status_OK && emit_op(&cc, NGCOp_End, 0) == Status_OK &&
+        (expr = malloc(sizeof(ngc_expr_t) + cc.size))) {
+        expr->length = end - start;
+        expr->depth = cc.max_depth;
+        memcpy(expr->code, code, cc.size);
+        *pos = end;
+    }
+
+    return expr;
+}
+
+/*! \brief Returns number of characters in the source text of a compiled expression.
+
+\param expr pointer to compiled expression.
+\returns number of characters.
+*/
+uint_fast8_t ngc_expression_length (ngc_expr_t *expr)
+{
+    return expr->length;
+}
+
+/*! \brief Evaluate compiled expression and set result if successful.
+
+\param expr pointer to compiled expression.
+\param value pointer to float where result is to be stored.
+\returns #Status_OK enum value if evaluated without error, appropriate \ref status_code_t enum value if not.
+*/
+status_code_t ngc_exec_expression (ngc_expr_t *expr, float *value)
+{
+    float stack[MAX_EVAL_STACK], *sp = stack - 1;
+    uint8_t *pc = expr->code;
+    status_code_t status = Status_OK;
+
+    while(status == Status_OK) switch((ngc_opcode_t)*pc++) {
+
+        case NGCOp_End:
+            *value = *sp;
+            return Status_OK;
+
+        case NGCOp_Push:
+            memcpy(++sp, pc, sizeof(float));
+            pc += sizeof(float);
+            break;
+
+        case NGCOp_Check:
+            if(isnan(*sp) || isinf(*sp))
+                status = Status_ExpressionInvalidResult;
+            break;
+
+        case NGCOp_Integer:
+            {
+                float fvalue = *sp;
+                *sp = floorf(fvalue);
+                if((fvalue - *sp) > 0.9999f)
+                    *sp = ceilf(fvalue);
+                else if((fvalue - *sp) > 0.0001f)
+                    status = Status_GcodeCommandValueNotInteger;
+            }
+            break;
+
+        case NGCOp_Negate:
+            *sp = -*sp;
+            break;
+
+        case NGCOp_Param:
+            if(*sp < 0.0f || !ngc_param_get((ngc_param_id_t)(int32_t)*sp, sp))
+                status = Status_GcodeValueOutOfRange;
+            break;
+
+        case NGCOp_NamedParam:
+            if(!ngc_named_param_get((char *)pc, ++sp))
+                status = Status_BadNumberFormat;
+            pc = (uint8_t *)strchr((char *)pc, '\0') + 1;
+            break;
+
+        case NGCOp_Exists:
+            *++sp = ngc_named_param_exists((char *)pc) ? 1.0f : 0.0f;
+            pc = (uint8_t *)strchr((char *)pc, '\0') + 1;
+            break;
+
+        case NGCOp_Setting:
+        case NGCOp_SettingBit:
+            {
+                const setting_detail_t *setting;
+                bool get_bit = *(pc - 1) == NGCOp_SettingBit;
+                int32_t bitnum = get_bit ? (int32_t)*sp-- : 0, setting_id = (int32_t)*sp;
+
+                if(bitnum < 0 || bitnum > 31)
+                    status = Status_ExpressionArgumentOutOfRange;
+                else if((setting = setting_get_details((setting_id_t)setting_id, NULL))) {
+
+                    uint_fast8_t offset = setting_id - setting->id;
+
+                    if(setting->datatype == Format_Decimal)
+                        *sp = setting_get_float_value(setting, offset);
+                    else if(setting_is_integer(setting) || setting_is_list(setting)) {
+                        *sp = (float)setting_get_int_value(setting, offset);
+                        if(get_bit)
+                            *sp = (((uint32_t)*sp >> bitnum) & 0x1) ? 1.0f : 0.0f;
+                    } else
+                        status = Status_ExpressionArgumentOutOfRange;
+                } else
+                    status = Status_ExpressionArgumentOutOfRange;
+            }
+            break;
+
+        case NGCOp_Atan:
+            sp--;
+            *sp = atan2f(*sp, *(sp + 1)) * DEGRAD;
+            break;
+
+        case NGCOp_Unary:
+            status = execute_unary(sp, (ngc_unary_op_t)*pc++);
+            break;
+
+        case NGCOp_Binary:
+            sp--;
+            status = execute_binary(sp, (ngc_binary_op_t)*pc++, sp + 1);
+            break;
+
+        default:
+            status = Status_ExpressionUknownOp;
+            break;
+    }
+
+    return status;
+}
+
 /**/
 
 static int8_t get_format (char c, int8_t pos, uint8_t *decimals)
@@ -3,12 +3,17 @@
 #ifndef _NGC_EXPR_H_
 #define _NGC_EXPR_H_
 
+typedef struct ngc_expr ngc_expr_t;
+
 status_code_t ngc_read_name (char *line, uint_fast8_t *pos, char *buffer);
 status_code_t ngc_read_real_value (char *line, uint_fast8_t *pos, float *value);
 status_code_t ngc_read_integer_value(char *line, uint_fast8_t *pos, int32_t *value);
 status_code_t ngc_read_integer_unsigned (char *line, uint_fast8_t *pos, uint32_t *value);
 status_code_t ngc_read_parameter (char *line, uint_fast8_t *pos, float *value, bool check);
 status_code_t ngc_eval_expression (char *line, uint_fast8_t *pos, float *value);
+ngc_expr_t *ngc_compile_expression (char *line, uint_fast8_t *pos);
+uint_fast8_t ngc_expression_length (ngc_expr_t *expr);
+status_code_t ngc_exec_expression (ngc_expr_t *expr, float *value);
 char *ngc_substitute_parameters (char *line);
 char *ngc_process_comment (char *comment);
 
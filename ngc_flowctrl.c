@@ -25,6 +25,7 @@
 
 #if NGC_EXPRESSIONS_ENABLE
 
+#include <ctype.h>
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
@@ -39,6 +40,18 @@
 #define NGC_STACK_DEPTH 20
 #endif
 
+#ifndef NGC_EXPR_CACHE_SIZE
+#define NGC_EXPR_CACHE_SIZE 32
+#endif
+
+#ifndef NGC_SUB_INDEX_HASH_SIZE
+#define NGC_SUB_INDEX_HASH_SIZE 32 // Must be a power of 2.
+#endif
+
+#ifndef NGC_SUB_INDEX_MAX_FILE_SIZE
+#define NGC_SUB_INDEX_MAX_FILE_SIZE (512 * 1024) // Larger files are not indexed.
+#endif
+
 typedef enum {
     NGCFlowCtrl_NoOp = 0,
     NGCFlowCtrl_If,
@@ -67,6 +80,56 @@ typedef struct ngc_sub {
     struct ngc_sub *next;
 } ngc_sub_t;
 
+typedef struct {
+    uint32_t o_label;
+    size_t sub_pos;     // File position of the line following the sub statement.
+    size_t end_pos;     // File position of the line following the endsub statement, 0 if not found.
+    int16_t next;       // Index of next label in hash bucket, -1 if last.
+} ngc_sub_label_t;
+
+typedef struct ngc_sub_index {
+    vfs_file_t *file;
+    uint16_t n_labels;
+    uint16_t size;
+    int16_t bucket[NGC_SUB_INDEX_HASH_SIZE];
+    ngc_sub_label_t *labels;
+    struct ngc_sub_index *next;
+} ngc_sub_index_t;
+
+typedef struct ngc_expr_cache {
+    vfs_file_t *file;
+    size_t file_pos;
+    uint_fast8_t line_pos;
+    ngc_expr_t *expr;               // Compiled expression, NULL if compilation failed.
+    struct ngc_expr_cache *next;
+} ngc_expr_cache_t;
+
+#if NGC_MACRO_CACHE_SIZE
+
+typedef struct ngc_macro {
+    const vfs_t *fs;        // File system the macro was loaded from.
+    size_t size;
+    uint32_t last_used;
+    uint_fast8_t refcount;  // Number of open files referencing the macro.
+    bool stale;
+    char *data;
+    struct ngc_macro *next;
+    char path[1];           // Path, followed by file content.
+} ngc_macro_t;
+
+typedef struct {
+    ngc_macro_t *macro;
+    size_t pos;
+} ngc_macro_file_t;
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+} ngc_macro_cache_stats_t;
+
+#endif
+
 typedef struct {
     uint32_t o_label;
     ngc_cmd_t operation;
@@ -74,6 +137,7 @@ typedef struct {
     vfs_file_t *file;
     size_t file_pos;
     char *expr;
+    uint_fast8_t expr_pos;
     uint32_t repeats;
     bool skip;
     bool handled;
@@ -83,8 +147,21 @@ typedef struct {
 static volatile int_fast8_t stack_idx = -1;
 static bool skip_sub = false;
 static ngc_sub_t *subs = NULL, *exec_sub = NULL;
+static ngc_sub_index_t *sub_indexes = NULL;
 static ngc_stack_entry_t stack[NGC_STACK_DEPTH] = {0};
+static uint_fast8_t n_cached = 0;
+static ngc_expr_cache_t *expr_cache = NULL;
+static vfs_file_t *line_file = NULL;
+static size_t line_file_pos = 0;
 static on_gcode_message_ptr on_gcode_comment;
+static on_file_end_ptr on_file_end;
+#if NGC_MACRO_CACHE_SIZE
+static uint32_t macro_clock = 0;
+static size_t macro_cache_used = 0;
+static ngc_macro_t *macros = NULL;
+static ngc_macro_cache_stats_t macro_stats = {0};
+static on_vfs_changed_ptr on_fs_changed;
+#endif
 
 static status_code_t read_command (char *line, uint_fast8_t *pos, ngc_cmd_t *operation)
 {
@@ -202,16 +279,12 @@ static status_code_t read_command (char *line, uint_fast8_t *pos, ngc_cmd_t *ope
 static ngc_sub_t *get_refcount (uint32_t *refcount)
 {
     ngc_sub_t *sub, *last = NULL;
-    uint32_t o_label = 0;
-
-    if((sub = subs)) do {
-        if(sub->o_label > NGC_MAX_PARAM_ID)
-            o_label = sub->o_label;
-    } while((sub = sub->next));
 
+    // The last called named sub is the first in the list.
     if((sub = subs)) do {
-        if(sub->o_label == o_label) {
-            last = sub;
+        if(last ? sub->o_label == last->o_label : sub->o_label > NGC_MAX_PARAM_ID) {
+            if(last == NULL)
+                last = sub;
             (*refcount)++;
         }
     } while((sub = sub->next));
@@ -219,28 +292,33 @@ static ngc_sub_t *get_refcount (uint32_t *refcount)
     return last;
 }
 
-static ngc_sub_t *add_sub (uint32_t o_label, vfs_file_t *file)
+static ngc_sub_t *add_sub (uint32_t o_label, vfs_file_t *file, size_t file_pos)
 {
     ngc_sub_t *sub;
 
     if((sub = malloc(sizeof(ngc_sub_t))) != NULL) {
         sub->o_label = o_label;
         sub->file = file;
-        sub->file_pos = vfs_tell(file);
-        sub->next = NULL;
-        if(subs == NULL)
-            subs = sub;
-        else {
-            ngc_sub_t *last = subs;
-            while(last->next)
-                last = last->next;
-            last->next = sub;
-        }
+        sub->file_pos = file_pos;
+        sub->next = subs;
+        subs = sub;
     }
 
     return sub;
 }
 
+static ngc_sub_t *get_sub (uint32_t o_label, vfs_file_t *file)
+{
+    ngc_sub_t *sub;
+
+    if((sub = subs)) do {
+        if(sub->o_label == o_label && sub->file == file)
+            break;
+    } while((sub = sub->next));
+
+    return sub;
+}
+
 static void clear_subs (vfs_file_t *file)
 {
     ngc_sub_t *current = subs, *prev = NULL, *next;
@@ -262,6 +340,276 @@ static void clear_subs (vfs_file_t *file)
     }
 }
 
+// Subroutine label index, built by scanning the file once on first use.
+// Records the positions of numbered sub and endsub statements so that calls
+// and sub definitions can be handled by a seek instead of reading through the file.
+
+static ngc_sub_label_t *sub_index_get (ngc_sub_index_t *index, uint32_t o_label)
+{
+    int16_t idx = index->bucket[o_label & (NGC_SUB_INDEX_HASH_SIZE - 1)];
+
+    while(idx >= 0 && index->labels[idx].o_label != o_label)
+        idx = index->labels[idx].next;
+
+    return idx >= 0 ? &index->labels[idx] : NULL;
+}
+
+// Parses a line for a numbered sub or endsub statement, whitespace and comments are skipped.
+// Returns label or 0 if not found, end is set true if the statement is endsub.
+static uint32_t sub_index_parse (char *line, bool *end)
+{
+    uint32_t o_label = 0;
+
+    if(*line == 'N')
+        while(isdigit(*++line));
+
+    if(*line++ == 'O' && isdigit(*line)) {
+
+        while(isdigit(*line))
+            o_label = o_label * 10 + (*line++ - '0');
+
+        if(o_label > NGC_MAX_PARAM_ID)
+            o_label = 0;
+        else if(!(*end = !strncmp(line, "ENDSUB", 6)) && strncmp(line, "SUB", 3))
+            o_label = 0;
+    }
+
+    return o_label;
+}
+
+static bool sub_index_add (ngc_sub_index_t *index, uint32_t o_label, bool end, size_t file_pos)
+{
+    ngc_sub_label_t *label = sub_index_get(index, o_label);
+
+    if(label == NULL && !end) {
+
+        if(index->n_labels == index->size) {
+
+            uint16_t size = index->size ? index->size * 2 : 8;
+            ngc_sub_label_t *labels;
+
+            if(size > INT16_MAX || (labels = realloc(index->labels, size * sizeof(ngc_sub_label_t))) == NULL)
+                return false;
+
+            index->size = size;
+            index->labels = labels;
+        }
+
+        label = &index->labels[index->n_labels];
+        label->o_label = o_label;
+        label->sub_pos = file_pos;
+        label->end_pos = 0;
+        label->next = index->bucket[o_label & (NGC_SUB_INDEX_HASH_SIZE - 1)];
+        index->bucket[o_label & (NGC_SUB_INDEX_HASH_SIZE - 1)] = index->n_labels++;
+    } else if(label && end && label->end_pos == 0)
+        label->end_pos = file_pos;
+
+    return true;
+}
+
+// Scans the file for numbered sub and endsub statements.
+// The step segment buffer is kept filled between chunks read so that motion continues while a large file
+// is scanned. Realtime commands are not executed as the file is not at the stream position, the scan is
+// aborted on a pending reset and the index discarded. The file is then left as is, it is closed by the reset.
+static void sub_index_scan (ngc_sub_index_t *index)
+{
+    bool ok = true, end;
+    char buf[64], line[24], c, comment = '\0';
+    uint32_t o_label;
+    size_t file_pos = 0, raw_pos = vfs_tell(index->file), len;
+    uint_fast8_t char_counter = 0, idx, chunks = 0;
+
+    if(vfs_seek(index->file, 0) != 0)
+        return;
+
+    while(ok && (len = vfs_read(buf, 1, sizeof(buf), index->file))) {
+
+        if(!(++chunks & 0x07)) {
+            if(sys.abort || bit_istrue(sys.rt_exec_state, EXEC_RESET)) {
+                index->n_labels = 0;
+                return;
+            }
+            st_prep_buffer();
+        }
+
+        for(idx = 0; ok && idx < len; idx++) {
+
+            file_pos++;
+
+            if((c = buf[idx]) == ASCII_LF || c == ASCII_CR) {
+                line[char_counter] = '\0';
+                if(char_counter && (o_label = sub_index_parse(line, &end)))
+                    ok = sub_index_add(index, o_label, end, file_pos);
+                char_counter = 0;
+                comment = '\0';
+            } else if(comment) {
+                if(comment == '(' && c == ')')
+                    comment = '\0';
+            } else if(c == '(' || c == ';')
+                comment = c;
+            else if(c > ' ' && char_counter < sizeof(line) - 1)
+                line[char_counter++] = CAPS(c);
+        }
+    }
+
+    if(ok && char_counter) {
+        line[char_counter] = '\0';
+        if((o_label = sub_index_parse(line, &end)))
+            ok = sub_index_add(index, o_label, end, file_pos);
+    }
+
+    if(!ok)
+        index->n_labels = 0;
+
+    // Restore file position, any stream read-ahead buffer is still valid.
+    vfs_seek(index->file, raw_pos);
+}
+
+// Returns index for the file, it is created on first call.
+// Returns NULL if the file could not be indexed.
+static ngc_sub_index_t *sub_index (vfs_file_t *file)
+{
+    ngc_sub_index_t *index = sub_indexes;
+
+    while(index && index->file != file)
+        index = index->next;
+
+    if(index == NULL && (index = calloc(1, sizeof(ngc_sub_index_t)))) {
+
+        uint_fast8_t idx = NGC_SUB_INDEX_HASH_SIZE;
+
+        do {
+            index->bucket[--idx] = -1;
+        } while(idx);
+
+        index->file = file;
+        index->next = sub_indexes;
+        sub_indexes = index;
+
+        if(file->size <= NGC_SUB_INDEX_MAX_FILE_SIZE)
+            sub_index_scan(index);
+    }
+
+    return index && index->n_labels ? index : NULL;
+}
+
+static void sub_index_clear (vfs_file_t *file)
+{
+    ngc_sub_index_t *index = sub_indexes, *prev = NULL, *next;
+
+    while(index) {
+        next = index->next;
+        if(file == NULL || file == index->file) {
+            if(prev)
+                prev->next = next;
+            else
+                sub_indexes = next;
+            if(index->labels)
+                free(index->labels);
+            free(index);
+        } else
+            prev = index;
+        index = next;
+    }
+}
+
+// Expression bytecode cache, compiled expressions are keyed by file, position
+// of the end of the line in the file and position of the expression in the line.
+// Entries are kept in most recently used order, the least recently used entry is replaced when the cache is full.
+// Expressions that fail to compile are cached without bytecode so that compilation is not retried on each evaluation.
+
+static ngc_expr_t *expr_cache_get (vfs_file_t *file, size_t file_pos, uint_fast8_t line_pos, char *expr)
+{
+    ngc_expr_cache_t *entry = expr_cache, *prev = NULL, *prev_last = NULL;
+
+    while(entry && !(entry->line_pos == line_pos && entry->file_pos == file_pos && entry->file == file)) {
+        prev_last = prev;
+        prev = entry;
+        entry = entry->next;
+    }
+
+    if(entry) {
+        if(prev) { // Move to front.
+            prev->next = entry->next;
+            entry->next = expr_cache;
+            expr_cache = entry;
+        }
+        return entry->expr;
+    }
+
+    if(n_cached < NGC_EXPR_CACHE_SIZE) {
+        if((entry = malloc(sizeof(ngc_expr_cache_t))))
+            n_cached++;
+    } else if((entry = prev)) { // Replace the least recently used entry, last in the list.
+        if(prev_last)
+            prev_last->next = NULL;
+        else
+            expr_cache = NULL;
+        if(entry->expr)
+            free(entry->expr);
+    }
+
+    if(entry) {
+
+        uint_fast8_t pos = 0;
+
+        entry->expr = ngc_compile_expression(expr, &pos);
+        entry->file = file;
+        entry->file_pos = file_pos;
+        entry->line_pos = line_pos;
+        entry->next = expr_cache;
+        expr_cache = entry;
+    }
+
+    return entry ? entry->expr : NULL;
+}
+
+static void expr_cache_clear (vfs_file_t *file)
+{
+    ngc_expr_cache_t *entry = expr_cache, *prev = NULL, *next;
+
+    while(entry) {
+        next = entry->next;
+        if(file == NULL || file == entry->file) {
+            if(prev)
+                prev->next = next;
+            else
+                expr_cache = next;
+            if(entry->expr)
+                free(entry->expr);
+            free(entry);
+            n_cached--;
+        } else
+            prev = entry;
+        entry = next;
+    }
+}
+
+// Evaluate expression in the line currently being executed, from the cache if the line is read from a file.
+static status_code_t eval_expression (char *line, uint_fast8_t *pos, float *value)
+{
+    ngc_expr_t *expr;
+
+    if(line_file && line[*pos] == '[' && (expr = expr_cache_get(line_file, line_file_pos, *pos, line + *pos))) {
+        *pos += ngc_expression_length(expr);
+        return ngc_exec_expression(expr, value);
+    }
+
+    return ngc_eval_expression(line, pos, value);
+}
+
+// Evaluate the expression of a while loop, from the cache if possible.
+static status_code_t eval_while_expression (ngc_stack_entry_t *entry, float *value)
+{
+    uint_fast8_t pos = 0;
+    ngc_expr_t *expr;
+
+    if((expr = expr_cache_get(entry->file, entry->file_pos, entry->expr_pos, entry->expr)))
+        return ngc_exec_expression(expr, value);
+
+    return ngc_eval_expression(entry->expr, &pos, value);
+}
+
 static status_code_t stack_push (uint32_t o_label, ngc_cmd_t operation)
 {
     if(stack_idx < (NGC_STACK_DEPTH - 1) && (operation != NGCFlowCtrl_Call || ngc_call_push(&stack[stack_idx + 1]))) {
@@ -302,9 +650,11 @@ static void stack_unwind_sub (uint32_t o_label)
             if(stack[stack_idx].sub == get_refcount(&count) && count == 1)
                 ngc_string_param_delete((ngc_string_id_t)o_label);
             clear_subs(stack[stack_idx].file);
+            sub_index_clear(stack[stack_idx].file);
+            expr_cache_clear(stack[stack_idx].file);
             stream_redirect_close(stack[stack_idx].file);
         } else
-            vfs_seek(stack[stack_idx].file, stack[stack_idx].file_pos);
+            stream_file_seek(stack[stack_idx].file, stack[stack_idx].file_pos);
 
         stack_pull();
     }
@@ -312,11 +662,258 @@ static void stack_unwind_sub (uint32_t o_label)
     exec_sub = stack_idx >= 0 ? stack[stack_idx].sub : NULL;
 }
 
+#if NGC_MACRO_CACHE_SIZE
+
+// In-memory file system serving cached macro files.
+
+static void macro_fs_close (vfs_file_t *file);
+
+static size_t macro_fs_read (void *buffer, size_t size, size_t count, vfs_file_t *file)
+{
+    ngc_macro_file_t *handle = (ngc_macro_file_t *)&file->handle;
+    size_t length = handle->macro->size - handle->pos;
+
+    if((count = size * count) < length)
+        length = count;
+
+    memcpy(buffer, handle->macro->data + handle->pos, length);
+    handle->pos += length;
+
+    return length / size;
+}
+
+static size_t macro_fs_write (const void *buffer, size_t size, size_t count, vfs_file_t *file)
+{
+    return 0;
+}
+
+static size_t macro_fs_tell (vfs_file_t *file)
+{
+    return ((ngc_macro_file_t *)&file->handle)->pos;
+}
+
+static int macro_fs_seek (vfs_file_t *file, size_t offset)
+{
+    ngc_macro_file_t *handle = (ngc_macro_file_t *)&file->handle;
+
+    if(offset > handle->macro->size)
+        return -1;
+
+    handle->pos = offset;
+
+    return 0;
+}
+
+static bool macro_fs_eof (vfs_file_t *file)
+{
+    ngc_macro_file_t *handle = (ngc_macro_file_t *)&file->handle;
+
+    return handle->pos >= handle->macro->size;
+}
+
+static const vfs_t macro_fs = {
+    .fs_name = "macro cache",
+    .fclose = macro_fs_close,
+    .fread = macro_fs_read,
+    .fwrite = macro_fs_write,
+    .ftell = macro_fs_tell,
+    .fseek = macro_fs_seek,
+    .feof = macro_fs_eof
+};
+
+static void macro_free (ngc_macro_t *macro)
+{
+    ngc_macro_t *prev = macros;
+
+    if(macro == macros)
+        macros = macro->next;
+    else while(prev) {
+        if(prev->next == macro) {
+            prev->next = macro->next;
+            break;
+        }
+        prev = prev->next;
+    }
+
+    macro_cache_used -= macro->size;
+    free(macro);
+}
+
+static void macro_fs_close (vfs_file_t *file)
+{
+    ngc_macro_t *macro = ((ngc_macro_file_t *)&file->handle)->macro;
+
+    if(--macro->refcount == 0 && macro->stale)
+        macro_free(macro);
+
+    free(file);
+}
+
+// Evict least recently used macros not in use until size bytes is available.
+static bool macro_make_room (size_t size)
+{
+    ngc_macro_t *macro, *lru;
+
+    while(macro_cache_used + size > NGC_MACRO_CACHE_SIZE) {
+
+        lru = NULL;
+
+        if((macro = macros)) do {
+            if(macro->refcount == 0 && (lru == NULL || macro->last_used < lru->last_used))
+                lru = macro;
+        } while((macro = macro->next));
+
+        if(lru == NULL)
+            return false;
+
+        macro_free(lru);
+        macro_stats.evictions++;
+    }
+
+    return true;
+}
+
+static ngc_macro_t *macro_load (char *filename)
+{
+    vfs_stat_t st;
+    vfs_file_t *file;
+    ngc_macro_t *macro = NULL;
+
+    if(vfs_stat(filename, &st) != 0 || st.st_size == 0 || st.st_size > NGC_MACRO_CACHE_SIZE)
+        return NULL;
+
+    macro_stats.misses++;
+
+    if(macro_make_room(st.st_size) &&
+        (macro = malloc(sizeof(ngc_macro_t) + strlen(filename) + st.st_size))) {
+
+        macro->data = strcpy(macro->path, filename) + strlen(filename) + 1;
+
+        if((file = vfs_open(filename, "r"))) {
+            macro->fs = file->fs;
+            macro->size = vfs_read(macro->data, 1, st.st_size, file);
+            vfs_close(file);
+        } else
+            macro->size = 0;
+
+        if(macro->size == st.st_size) {
+            macro->refcount = 0;
+            macro->stale = false;
+            macro->next = macros;
+            macros = macro;
+            macro_cache_used += macro->size;
+        } else {
+            free(macro);
+            macro = NULL;
+        }
+    }
+
+    return macro;
+}
+
+// Returns a file in the in-memory file system for a cached macro,
+// NULL if the macro cannot be cached.
+static vfs_file_t *macro_open (char *filename)
+{
+    vfs_stat_t st;
+    vfs_file_t *file = NULL;
+    ngc_macro_t *macro = macros;
+
+    while(macro && (macro->stale || strcmp(macro->path, filename)))
+        macro = macro->next;
+
+    // Changes to files on hidden mounts are not notified via vfs.on_fs_changed,
+    // drop the cached content if the file is gone or its size has changed.
+    if(macro && (vfs_stat(filename, &st) != 0 || st.st_size != macro->size)) {
+        macro->stale = true;
+        if(macro->refcount == 0)
+            macro_free(macro);
+        macro = NULL;
+    }
+
+    if(macro)
+        macro_stats.hits++;
+    else
+        macro = macro_load(filename);
+
+    if(macro && (file = malloc(sizeof(vfs_file_t) + sizeof(ngc_macro_file_t)))) {
+
+        ngc_macro_file_t *handle = (ngc_macro_file_t *)&file->handle;
+
+        file->fs = &macro_fs;
+        file->size = macro->size;
+        file->update = false;
+        handle->macro = macro;
+        handle->pos = 0;
+        macro->refcount++;
+        macro->last_used = ++macro_clock;
+    }
+
+    return file;
+}
+
+// Invalidate all macros loaded from a changed file system,
+// macros in use are freed when closed.
+static void macro_cache_invalidate (const vfs_t *fs)
+{
+    ngc_macro_t *macro = macros, *next;
+
+    while(macro) {
+        next = macro->next;
+        if(fs == NULL || macro->fs == fs) {
+            macro->stale = true;
+            if(macro->refcount == 0)
+                macro_free(macro);
+        }
+        macro = next;
+    }
+}
+
+static void onFsChanged (const vfs_t *fs)
+{
+    macro_cache_invalidate(fs);
+
+    if(on_fs_changed)
+        on_fs_changed(fs);
+}
+
+static status_code_t report_macro_cache (sys_state_t state, char *args)
+{
+    uint_fast16_t n_macros = 0;
+    ngc_macro_t *macro = macros;
+
+    while(macro) {
+        if(!macro->stale)
+            n_macros++;
+        macro = macro->next;
+    }
+
+    hal.stream.write("[MACROCACHE:");
+    hal.stream.write(uitoa(macro_stats.hits));
+    hal.stream.write(",");
+    hal.stream.write(uitoa(macro_stats.misses));
+    hal.stream.write(",");
+    hal.stream.write(uitoa(macro_stats.evictions));
+    hal.stream.write(",");
+    hal.stream.write(uitoa(n_macros));
+    hal.stream.write(",");
+    hal.stream.write(uitoa(macro_cache_used));
+    hal.stream.write(",");
+    hal.stream.write(uitoa(NGC_MACRO_CACHE_SIZE));
+    hal.stream.write("]" ASCII_EOL);
+
+    return Status_OK;
+}
+
+#endif // NGC_MACRO_CACHE_SIZE
+
 // Public functions
 
 void ngc_flowctrl_unwind_stack (vfs_file_t *file)
 {
     clear_subs(file);
+    sub_index_clear(file);
+    expr_cache_clear(file);
     while(stack_idx >= 0 && stack[stack_idx].file == file)
         stack_pull();
 }
@@ -343,6 +940,14 @@ static status_code_t onGcodeComment (char *comment)
     return status;
 }
 
+static status_code_t onFileEnd (vfs_file_t *file, status_code_t status)
+{
+    sub_index_clear(file);
+    expr_cache_clear(file);
+
+    return on_file_end ? on_file_end(file, status) : status;
+}
+
 void ngc_flowctrl_init (void)
 {
     static bool init_ok = false;
@@ -351,9 +956,27 @@ void ngc_flowctrl_init (void)
         init_ok = true;
         on_gcode_comment = grbl.on_gcode_comment;
         grbl.on_gcode_comment = onGcodeComment;
+        on_file_end = grbl.on_file_end;
+        grbl.on_file_end = onFileEnd;
+#if NGC_MACRO_CACHE_SIZE
+        static const sys_command_t macro_command_list[] = {
+            {"MACROCACHE", report_macro_cache, { .noargs = On, .allow_blocking = On }, { .str = "output macro cache hits, misses, evictions, entries, bytes used and size" } }
+        };
+
+        static sys_commands_t macro_commands = {
+            .n_commands = sizeof(macro_command_list) / sizeof(sys_command_t),
+            .commands = macro_command_list
+        };
+
+        on_fs_changed = vfs.on_fs_changed;
+        vfs.on_fs_changed = onFsChanged;
+        system_register_commands(&macro_commands);
+#endif
     }
 
     clear_subs(NULL);
+    sub_index_clear(NULL);
+    expr_cache_clear(NULL);
     while(stack_idx >= 0)
         stack_pull();
 }
@@ -406,6 +1029,18 @@ static status_code_t onNamedSubEOF (vfs_file_t *file, status_code_t status)
     return status;
 }
 
+static vfs_file_t *macro_redirect_read (char *filename)
+{
+#if NGC_MACRO_CACHE_SIZE
+    vfs_file_t *file;
+
+    if((file = macro_open(filename)))
+        return stream_redirect_read_file(file, onNamedSubError, onNamedSubEOF);
+#endif
+
+    return stream_redirect_read(filename, onNamedSubError, onNamedSubEOF);
+}
+
 status_code_t ngc_flowctrl (uint32_t o_label, char *line, uint_fast8_t *pos, bool *skip)
 {
     float value;
@@ -417,13 +1052,16 @@ status_code_t ngc_flowctrl (uint32_t o_label, char *line, uint_fast8_t *pos, boo
     if((status = read_command(line, pos, &operation)) != Status_OK)
         return status;
 
+    line_file = hal.stream.file;
+    line_file_pos = line_file ? stream_file_tell(line_file) : 0;
+
     skipping = skip_sub || (stack_idx >= 0 && stack[stack_idx].skip);
     last_op = stack_idx >= 0 ? stack[stack_idx].operation : (skip_sub ? NGCFlowCtrl_Sub : NGCFlowCtrl_NoOp);
 
     switch(operation) {
 
         case NGCFlowCtrl_If:
-            if(!skipping && (status = ngc_eval_expression(line, pos, &value)) == Status_OK) {
+            if(!skipping && (status = eval_expression(line, pos, &value)) == Status_OK) {
                 if((status = stack_push(o_label, operation)) == Status_OK) {
                     stack[stack_idx].skip = value == 0.0f;
                     stack[stack_idx].handled = !stack[stack_idx].skip;
@@ -435,7 +1073,7 @@ status_code_t ngc_flowctrl (uint32_t o_label, char *line, uint_fast8_t *pos, boo
             if(last_op == NGCFlowCtrl_If || last_op == NGCFlowCtrl_ElseIf) {
                 if(o_label == stack[stack_idx].o_label &&
                     !(stack[stack_idx].skip = stack[stack_idx].handled) && !stack[stack_idx].handled &&
-                      (status = ngc_eval_expression(line, pos, &value)) == Status_OK) {
+                      (status = eval_expression(line, pos, &value)) == Status_OK) {
                     if(!(stack[stack_idx].skip = value == 0.0f)) {
                         stack[stack_idx].operation = operation;
                         stack[stack_idx].handled = true;
@@ -466,7 +1104,7 @@ status_code_t ngc_flowctrl (uint32_t o_label, char *line, uint_fast8_t *pos, boo
         case NGCFlowCtrl_Do:
             if(hal.stream.file) {
                 if(!skipping && (status = stack_push(o_label, operation)) == Status_OK) {
-                    stack[stack_idx].file_pos = vfs_tell(hal.stream.file);
+                    stack[stack_idx].file_pos = stream_file_tell(hal.stream.file);
                     stack[stack_idx].skip = false;
                 }
             } else
@@ -476,21 +1114,23 @@ status_code_t ngc_flowctrl (uint32_t o_label, char *line, uint_fast8_t *pos, boo
         case NGCFlowCtrl_While:
             if(hal.stream.file) {
                 char *expr = line + *pos;
+                uint_fast8_t expr_pos = *pos;
                 if(stack_idx >= 0 && stack[stack_idx].brk) {
                     if(last_op == NGCFlowCtrl_Do && o_label == stack[stack_idx].o_label)
                         stack_pull();
-                } else if(!skipping && (status = ngc_eval_expression(line, pos, &value)) == Status_OK) {
+                } else if(!skipping && (status = eval_expression(line, pos, &value)) == Status_OK) {
                     if(last_op == NGCFlowCtrl_Do && o_label == stack[stack_idx].o_label) {
                         if(value != 0.0f)
-                            vfs_seek(stack[stack_idx].file, stack[stack_idx].file_pos);
+                            stream_file_seek(stack[stack_idx].file, stack[stack_idx].file_pos);
                         else
                             stack_pull();
                     } else if((status = stack_push(o_label, operation)) == Status_OK) {
                         if(!(stack[stack_idx].skip = value == 0.0f)) {
                             if((stack[stack_idx].expr = malloc(strlen(expr) + 1))) {
                                 strcpy(stack[stack_idx].expr, expr);
+                                stack[stack_idx].expr_pos = expr_pos;
                                 stack[stack_idx].file = hal.stream.file;
-                                stack[stack_idx].file_pos = vfs_tell(hal.stream.file);
+                                stack[stack_idx].file_pos = stream_file_tell(hal.stream.file);
                             } else
                                 status = Status_FlowControlOutOfMemory;
                         }
@@ -505,10 +1145,9 @@ status_code_t ngc_flowctrl (uint32_t o_label, char *line, uint_fast8_t *pos, boo
                 if(last_op == NGCFlowCtrl_While) {
                     if(o_label == stack[stack_idx].o_label) {
                         if(!skipping) {
-                            uint_fast8_t pos = 0;
-                            if(!stack[stack_idx].skip && (status = ngc_eval_expression(stack[stack_idx].expr, &pos, &value)) == Status_OK) {
+                            if(!stack[stack_idx].skip && (status = eval_while_expression(&stack[stack_idx], &value)) == Status_OK) {
                                 if(!(stack[stack_idx].skip = value == 0.0f))
-                                    vfs_seek(stack[stack_idx].file, stack[stack_idx].file_pos);
+                                    stream_file_seek(stack[stack_idx].file, stack[stack_idx].file_pos);
                             }
                         }
                         if(stack[stack_idx].skip)
@@ -522,12 +1161,12 @@ status_code_t ngc_flowctrl (uint32_t o_label, char *line, uint_fast8_t *pos, boo
 
         case NGCFlowCtrl_Repeat:
             if(hal.stream.file) {
-                if(!skipping && (status = ngc_eval_expression(line, pos, &value)) == Status_OK) {
+                if(!skipping && (status = eval_expression(line, pos, &value)) == Status_OK) {
                     if((status = stack_push(o_label, operation)) == Status_OK) {
                         value = nearbyintf(value);
                         if(!(stack[stack_idx].skip = value <= 0.0f)) {
                             stack[stack_idx].file = hal.stream.file;
-                            stack[stack_idx].file_pos = vfs_tell(hal.stream.file);
+                            stack[stack_idx].file_pos = stream_file_tell(hal.stream.file);
                             stack[stack_idx].repeats = (uint32_t)value;
                         }
                     }
@@ -541,7 +1180,7 @@ status_code_t ngc_flowctrl (uint32_t o_label, char *line, uint_fast8_t *pos, boo
                 if(last_op == NGCFlowCtrl_Repeat) {
                     if(o_label == stack[stack_idx].o_label) {
                         if(!skipping && stack[stack_idx].repeats && --stack[stack_idx].repeats)
-                            vfs_seek(stack[stack_idx].file, stack[stack_idx].file_pos);
+                            stream_file_seek(stack[stack_idx].file, stack[stack_idx].file_pos);
                         else
                             stack_pull();
                     }
@@ -576,21 +1215,20 @@ status_code_t ngc_flowctrl (uint32_t o_label, char *line, uint_fast8_t *pos, boo
 
                         case NGCFlowCtrl_Repeat:
                             if(stack[stack_idx].repeats && --stack[stack_idx].repeats)
-                                vfs_seek(stack[stack_idx].file, stack[stack_idx].file_pos);
+                                stream_file_seek(stack[stack_idx].file, stack[stack_idx].file_pos);
                             else
                                 stack[stack_idx].skip = true;
                             break;
 
                         case NGCFlowCtrl_Do:
-                            vfs_seek(stack[stack_idx].file, stack[stack_idx].file_pos);
+                            stream_file_seek(stack[stack_idx].file, stack[stack_idx].file_pos);
                             break;
 
                         case NGCFlowCtrl_While:
                             {
-                                uint_fast8_t pos = 0;
-                                if(!stack[stack_idx].skip && (status = ngc_eval_expression(stack[stack_idx].expr, &pos, &value)) == Status_OK) {
+                                if(!stack[stack_idx].skip && (status = eval_while_expression(&stack[stack_idx], &value)) == Status_OK) {
                                     if(!(stack[stack_idx].skip = value == 0))
-                                        vfs_seek(stack[stack_idx].file, stack[stack_idx].file_pos);
+                                        stream_file_seek(stack[stack_idx].file, stack[stack_idx].file_pos);
                                 }
                                 if(stack[stack_idx].skip) {
                                     if(stack[stack_idx].expr) {
@@ -613,29 +1251,42 @@ status_code_t ngc_flowctrl (uint32_t o_label, char *line, uint_fast8_t *pos, boo
             break;
 
         case NGCFlowCtrl_RaiseAlarm:
-            if(!skipping && ngc_eval_expression(line, pos, &value) == Status_OK)
+            if(!skipping && eval_expression(line, pos, &value) == Status_OK)
                 system_raise_alarm((alarm_code_t)value);
             break;
 
         case NGCFlowCtrl_RaiseError:
-            if(!skipping && ngc_eval_expression(line, pos, &value) == Status_OK)
+            if(!skipping && eval_expression(line, pos, &value) == Status_OK)
                 status = (status_code_t)value;
             break;
 
         case NGCFlowCtrl_Sub:
             if(hal.stream.file) {
-                ngc_sub_t *sub;
                 if(o_label > NGC_MAX_PARAM_ID) {
-
-                    if((sub = subs)) do {
-                        if(sub->o_label == o_label && sub->file == hal.stream.file)
-                            break;
-                    } while(sub->next && (sub = sub->next));
-
-                    if(sub == NULL || sub->o_label != o_label)
+                    if(get_sub(o_label, hal.stream.file) == NULL)
                         status = Status_FlowControlSyntaxError;
-                } else if(!(skip_sub = (sub = add_sub(o_label, hal.stream.file)) != NULL))
-                    status = Status_FlowControlOutOfMemory;
+                } else {
+
+                    ngc_sub_index_t *index;
+                    ngc_sub_label_t *label = NULL;
+
+                    if((index = sub_index(hal.stream.file)))
+                        label = sub_index_get(index, o_label);
+
+                    // The index holds the first definition of a label only, a later definition is a duplicate.
+                    // It is reported and skipped by reading through it, the first definition stays in effect.
+                    if(label && label->sub_pos != stream_file_tell(hal.stream.file)) {
+                        char msg[40];
+                        sprintf(msg, "duplicate sub o%lu ignored", (unsigned long)o_label);
+                        report_message(msg, Message_Warning);
+                        skip_sub = true;
+                    } else if(get_sub(o_label, hal.stream.file) == NULL && add_sub(o_label, hal.stream.file, stream_file_tell(hal.stream.file)) == NULL)
+                        status = Status_FlowControlOutOfMemory;
+                    else if(label && label->end_pos)
+                        stream_file_seek(hal.stream.file, label->end_pos); // Skip sub body.
+                    else
+                        skip_sub = true;
+                }
             } else
                 status = Status_FlowControlNotExecutingMacro;
             break;
@@ -672,24 +1323,30 @@ status_code_t ngc_flowctrl (uint32_t o_label, char *line, uint_fast8_t *pos, boo
 #if LITTLEFS_ENABLE == 1
                             sprintf(filename, "/littlefs/%s.macro", subname);
 
-                            if((file = stream_redirect_read(filename, onNamedSubError, onNamedSubEOF)) == NULL) {
+                            if((file = macro_redirect_read(filename)) == NULL) {
                                 sprintf(filename, "/%s.macro", subname);
-                                file = stream_redirect_read(filename, onNamedSubError, onNamedSubEOF);
+                                file = macro_redirect_read(filename);
                             }
 #else
                             sprintf(filename, "/%s.macro", subname);
-                            file = stream_redirect_read(filename, onNamedSubError, onNamedSubEOF);
+                            file = macro_redirect_read(filename);
 #endif
                             if(file) {
-                                if((sub = add_sub(o_label, file)) == NULL)
+                                if((sub = add_sub(o_label, file, stream_file_tell(file))) == NULL)
                                     status = Status_FlowControlOutOfMemory;
                             } else
                                 status = Status_FileOpenFailed;
                        }
-                    } else if((sub = subs)) do {
-                        if(sub->o_label == o_label && sub->file == hal.stream.file)
-                            break;
-                    } while((sub = sub->next));
+                    } else if((sub = get_sub(o_label, hal.stream.file)) == NULL) {
+
+                        ngc_sub_index_t *index;
+                        ngc_sub_label_t *label;
+
+                        // Sub not yet seen, look it up in the index. Subs defined later in the file can thus be
+                        // called, unless the file is too large to be indexed.
+                        if((index = sub_index(hal.stream.file)) && (label = sub_index_get(index, o_label)))
+                            sub = add_sub(o_label, hal.stream.file, label->sub_pos);
+                    }
 
                     if(sub == NULL)
                         status = Status_FlowControlSyntaxError;
@@ -699,7 +1356,7 @@ status_code_t ngc_flowctrl (uint32_t o_label, char *line, uint_fast8_t *pos, boo
                         ngc_param_id_t param_id = 1;
 
                         while(line[*pos] && status == Status_OK && param_id <= 30) {
-                            status = ngc_eval_expression(line, pos, &params[param_id - 1]);
+                            status = eval_expression(line, pos, &params[param_id - 1]);
                             param_id++;
                         }
 
@@ -711,7 +1368,7 @@ status_code_t ngc_flowctrl (uint32_t o_label, char *line, uint_fast8_t *pos, boo
 
                             stack[stack_idx].sub = exec_sub = sub;
                             stack[stack_idx].file = hal.stream.file;
-                            stack[stack_idx].file_pos = vfs_tell(hal.stream.file);
+                            stack[stack_idx].file_pos = stream_file_tell(hal.stream.file);
                             stack[stack_idx].repeats = 1;
 
                             for(param_id = 1; param_id <= 30; param_id++) {
@@ -724,7 +1381,7 @@ status_code_t ngc_flowctrl (uint32_t o_label, char *line, uint_fast8_t *pos, boo
                             if(status == Status_OK) {
                                 ngc_named_param_set("_value", 0.0f);
                                 ngc_named_param_set("_value_returned", 0.0f);
-                                vfs_seek(sub->file, sub->file_pos);
+                                stream_file_seek(sub->file, sub->file_pos);
                             }
                         }
                     }
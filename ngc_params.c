@@ -42,6 +42,14 @@
 #define NGC_MAX_CALL_LEVEL 10
 #endif
 
+#ifndef NGC_PARAM_HASH_SIZE
+#define NGC_PARAM_HASH_SIZE 16 // Number of hash buckets per scope, must be a power of 2.
+#endif
+
+#ifndef NGC_PARAM_ARENA_SIZE
+#define NGC_PARAM_ARENA_SIZE 256
+#endif
+
 typedef float (*ngc_param_get_ptr)(ngc_param_id_t id);
 typedef float (*ngc_named_param_get_ptr)(void);
 
@@ -52,7 +60,6 @@ typedef struct {
 } ngc_ro_param_t;
 
 typedef struct ngc_rw_param {
-    void *context;
     ngc_param_id_t id;
     float value;
     struct ngc_rw_param *next;
@@ -65,12 +72,25 @@ typedef struct {
 } ngc_named_ro_param_t;
 
 typedef struct ngc_named_rw_param {
-    void *context;
     char name[NGC_MAX_PARAM_LENGTH + 1];
     float value;
     struct ngc_named_rw_param *next;
 } ngc_named_rw_param_t;
 
+// Parameters are allocated from arena blocks owned by the scope,
+// all are released in one go when the scope is deleted.
+typedef struct ngc_param_arena {
+    struct ngc_param_arena *next;
+    size_t used;
+    uint8_t data[NGC_PARAM_ARENA_SIZE] __attribute__ ((aligned (4)));
+} ngc_param_arena_t;
+
+typedef struct {
+    ngc_rw_param_t *params[NGC_PARAM_HASH_SIZE];
+    ngc_named_rw_param_t *named_params[NGC_PARAM_HASH_SIZE];
+    ngc_param_arena_t *arena;
+} ngc_param_scope_t;
+
 typedef struct ngc_string_param {
     struct ngc_string_param *next;
     ngc_string_id_t id;
@@ -82,14 +102,14 @@ typedef struct {
     uint32_t level;
     void *context;
     gc_modal_t *modal_state;
+    ngc_param_scope_t *scope;
 } ngc_param_context_t;
 
 static int32_t call_level = -1;
 static void *call_context;
 static gc_modal_t *modal_state;
 static ngc_param_context_t call_levels[NGC_MAX_CALL_LEVEL];
-static ngc_rw_param_t *rw_params = NULL;
-static ngc_named_rw_param_t *rw_global_params = NULL;
+static ngc_param_scope_t global_scope = {0};
 static ngc_string_id_t ref_id = (uint32_t)-1;
 static ngc_string_param_t *ngc_string_params = NULL;
 
@@ -121,6 +141,87 @@ static float _relative_pos (uint_fast8_t axis)
     return value;
 }
 
+// Parameter scopes, the global scope holds global parameters and local parameters when not in a call.
+// Each call level with local parameters gets its own scope.
+
+static ngc_param_scope_t *get_scope (bool global, bool create)
+{
+    if(global || call_context == NULL)
+        return &global_scope;
+
+    if(call_levels[call_level].scope == NULL && create)
+        call_levels[call_level].scope = calloc(1, sizeof(ngc_param_scope_t));
+
+    return call_levels[call_level].scope;
+}
+
+static void *scope_alloc (ngc_param_scope_t *scope, size_t size)
+{
+    void *mem;
+
+    size = (size + 3) & ~3;
+
+    if(scope->arena == NULL || scope->arena->used + size > NGC_PARAM_ARENA_SIZE) {
+
+        ngc_param_arena_t *arena;
+
+        if((arena = malloc(sizeof(ngc_param_arena_t))) == NULL)
+            return NULL;
+
+        arena->used = 0;
+        arena->next = scope->arena;
+        scope->arena = arena;
+    }
+
+    mem = scope->arena->data + scope->arena->used;
+    scope->arena->used += size;
+
+    return mem;
+}
+
+static void scope_delete (ngc_param_scope_t *scope)
+{
+    ngc_param_arena_t *arena;
+
+    if(scope) {
+        while((arena = scope->arena)) {
+            scope->arena = arena->next;
+            free(arena);
+        }
+        free(scope);
+    }
+}
+
+static inline ngc_rw_param_t *scope_get_param (ngc_param_scope_t *scope, ngc_param_id_t id)
+{
+    ngc_rw_param_t *rw_param = scope->params[id & (NGC_PARAM_HASH_SIZE - 1)];
+
+    while(rw_param && rw_param->id != id)
+        rw_param = rw_param->next;
+
+    return rw_param;
+}
+
+static inline uint_fast8_t name_hash (const char *name)
+{
+    uint32_t hash = 5381;
+
+    while(*name)
+        hash = ((hash << 5) + hash) ^ (uint8_t)*name++;
+
+    return (uint_fast8_t)(hash & (NGC_PARAM_HASH_SIZE - 1));
+}
+
+static inline ngc_named_rw_param_t *scope_get_named_param (ngc_param_scope_t *scope, const char *name, uint_fast8_t hash)
+{
+    ngc_named_rw_param_t *rw_param = scope->named_params[hash];
+
+    while(rw_param && strcmp(rw_param->name, name))
+        rw_param = rw_param->next;
+
+    return rw_param;
+}
+
 // numbered parameters
 
 static float probe_coord (ngc_param_id_t id)
@@ -287,15 +388,10 @@ bool ngc_param_get (ngc_param_id_t id, float *value)
     *value = 0.0f;
 
     if(found) {
-        void *context = id > (ngc_param_id_t)30 ? NULL : call_context;
-        ngc_rw_param_t *rw_param = rw_params;
-        while(rw_param) {
-            if(rw_param->context == context && rw_param->id == id) {
-                *value = rw_param->value;
-                rw_param = NULL;
-            } else
-                rw_param = rw_param->next;
-        }
+        ngc_rw_param_t *rw_param;
+        ngc_param_scope_t *scope = get_scope(id > (ngc_param_id_t)30, false);
+        if(scope && (rw_param = scope_get_param(scope, id)))
+            *value = rw_param->value;
     } else do {
         idx--;
         if((found = id >= ngc_ro_params[idx].id_min && id <= ngc_ro_params[idx].id_max))
@@ -321,26 +417,13 @@ bool ngc_param_set (ngc_param_id_t id, float value)
 
     if(ok) {
 
-        void *context = id > (ngc_param_id_t)30 ? NULL : call_context;
-        ngc_rw_param_t *rw_param = rw_params, *rw_param_last = rw_params;
-
-        while(rw_param) {
-            if(rw_param->context == context && rw_param->id == id) {
-                break;
-            } else {
-                rw_param_last = rw_param;
-                rw_param = rw_param->next;
-            }
-        }
+        ngc_rw_param_t *rw_param = NULL;
+        ngc_param_scope_t *scope = get_scope(id > (ngc_param_id_t)30, value != 0.0f);
 
-        if(rw_param == NULL && value != 0.0f && (rw_param = malloc(sizeof(ngc_rw_param_t)))) {
+        if(scope && (rw_param = scope_get_param(scope, id)) == NULL && value != 0.0f && (rw_param = scope_alloc(scope, sizeof(ngc_rw_param_t)))) {
             rw_param->id = id;
-            rw_param->context = context;
-            rw_param->next = NULL;
-            if(rw_params == NULL)
-                rw_params = rw_param;
-            else
-                rw_param_last->next = rw_param;
+            rw_param->next = scope->params[id & (NGC_PARAM_HASH_SIZE - 1)];
+            scope->params[id & (NGC_PARAM_HASH_SIZE - 1)] = rw_param;
         }
 
         if(rw_param)
@@ -352,64 +435,65 @@ bool ngc_param_set (ngc_param_id_t id, float value)
     return ok;
 }
 
+// NOTE: must be sorted by name as lookup is done by binary search.
 PROGMEM static const ngc_named_ro_param_t ngc_named_ro_param[] = {
-    { .name = "_vmajor",              .id = NGCParam_vmajor },
-    { .name = "_vminor",              .id = NGCParam_vminor },
-    { .name = "_line",                .id = NGCParam_line },
-    { .name = "_motion_mode",         .id = NGCParam_motion_mode },
-    { .name = "_plane",               .id = NGCParam_plane },
+    { .name = "_a",                   .id = NGCParam_a },
+    { .name = "_abs_a",               .id = NGCParam_abs_a },
+    { .name = "_abs_b",               .id = NGCParam_abs_b },
+    { .name = "_abs_c",               .id = NGCParam_abs_c },
+    { .name = "_abs_u",               .id = NGCParam_abs_u },
+    { .name = "_abs_v",               .id = NGCParam_abs_v },
+    { .name = "_abs_w",               .id = NGCParam_abs_w },
+    { .name = "_abs_x",               .id = NGCParam_abs_x },
+    { .name = "_abs_y",               .id = NGCParam_abs_y },
+    { .name = "_abs_z",               .id = NGCParam_abs_z },
+    { .name = "_absolute",            .id = NGCParam_absolute },
+    { .name = "_adaptive_feed",       .id = NGCParam_adaptive_feed },
+    { .name = "_b",                   .id = NGCParam_b },
+    { .name = "_c",                   .id = NGCParam_c },
+    { .name = "_call_level",          .id = NGCParam_call_level },
     { .name = "_ccomp",               .id = NGCParam_ccomp },
-    { .name = "_metric",              .id = NGCParam_metric },
+    { .name = "_coord_system",        .id = NGCParam_coord_system },
+    { .name = "_current_pocket",      .id = NGCParam_current_pocket },
+    { .name = "_current_tool",        .id = NGCParam_current_tool },
+    { .name = "_feed",                .id = NGCParam_feed },
+    { .name = "_feed_hold",           .id = NGCParam_feed_hold },
+    { .name = "_feed_override",       .id = NGCParam_feed_override },
+    { .name = "_flood",               .id = NGCParam_flood },
+    { .name = "_ijk_absolute_mode",   .id = NGCParam_ijk_absolute_mode },
     { .name = "_imperial",            .id = NGCParam_imperial },
-    { .name = "_absolute",            .id = NGCParam_absolute },
     { .name = "_incremental",         .id = NGCParam_incremental },
     { .name = "_inverse_time",        .id = NGCParam_inverse_time },
-    { .name = "_units_per_minute",    .id = NGCParam_units_per_minute },
-    { .name = "_units_per_rev",       .id = NGCParam_units_per_rev },
-    { .name = "_coord_system",        .id = NGCParam_coord_system },
-    { .name = "_tool_offset",         .id = NGCParam_tool_offset },
-    { .name = "_retract_r_plane",     .id = NGCParam_retract_r_plane },
-    { .name = "_retract_old_z",       .id = NGCParam_retract_old_z },
-    { .name = "_spindle_rpm_mode",    .id = NGCParam_spindle_rpm_mode },
-    { .name = "_spindle_css_mode",    .id = NGCParam_spindle_css_mode },
-    { .name = "_ijk_absolute_mode",   .id = NGCParam_ijk_absolute_mode },
     { .name = "_lathe_diameter_mode", .id = NGCParam_lathe_diameter_mode },
     { .name = "_lathe_radius_mode",   .id = NGCParam_lathe_radius_mode },
-    { .name = "_spindle_on",          .id = NGCParam_spindle_on },
-    { .name = "_spindle_cw",          .id = NGCParam_spindle_cw },
+    { .name = "_line",                .id = NGCParam_line },
+    { .name = "_metric",              .id = NGCParam_metric },
     { .name = "_mist",                .id = NGCParam_mist },
-    { .name = "_flood",               .id = NGCParam_flood },
-    { .name = "_speed_override",      .id = NGCParam_speed_override },
-    { .name = "_feed_override",       .id = NGCParam_feed_override },
-    { .name = "_adaptive_feed",       .id = NGCParam_adaptive_feed },
-    { .name = "_feed_hold",           .id = NGCParam_feed_hold },
-    { .name = "_feed",                .id = NGCParam_feed },
+    { .name = "_motion_mode",         .id = NGCParam_motion_mode },
+    { .name = "_plane",               .id = NGCParam_plane },
+    { .name = "_probe_state",         .id = NGCParam_probe_state },
+    { .name = "_retract_old_z",       .id = NGCParam_retract_old_z },
+    { .name = "_retract_r_plane",     .id = NGCParam_retract_r_plane },
     { .name = "_rpm",                 .id = NGCParam_rpm },
-    { .name = "_x",                   .id = NGCParam_x },
-    { .name = "_y",                   .id = NGCParam_y },
-    { .name = "_z",                   .id = NGCParam_z },
-    { .name = "_a",                   .id = NGCParam_a },
-    { .name = "_b",                   .id = NGCParam_b },
-    { .name = "_c",                   .id = NGCParam_c },
+    { .name = "_selected_pocket",     .id = NGCParam_selected_pocket },
+    { .name = "_selected_tool",       .id = NGCParam_selected_tool },
+    { .name = "_speed_override",      .id = NGCParam_speed_override },
+    { .name = "_spindle_css_mode",    .id = NGCParam_spindle_css_mode },
+    { .name = "_spindle_cw",          .id = NGCParam_spindle_cw },
+    { .name = "_spindle_on",          .id = NGCParam_spindle_on },
+    { .name = "_spindle_rpm_mode",    .id = NGCParam_spindle_rpm_mode },
+    { .name = "_tool_offset",         .id = NGCParam_tool_offset },
+    { .name = "_toolsetter_state",    .id = NGCParam_toolsetter_state },
     { .name = "_u",                   .id = NGCParam_u },
+    { .name = "_units_per_minute",    .id = NGCParam_units_per_minute },
+    { .name = "_units_per_rev",       .id = NGCParam_units_per_rev },
     { .name = "_v",                   .id = NGCParam_v },
+    { .name = "_vmajor",              .id = NGCParam_vmajor },
+    { .name = "_vminor",              .id = NGCParam_vminor },
     { .name = "_w",                   .id = NGCParam_w },
-    { .name = "_abs_x",               .id = NGCParam_abs_x },
-    { .name = "_abs_y",               .id = NGCParam_abs_y },
-    { .name = "_abs_z",               .id = NGCParam_abs_z },
-    { .name = "_abs_a",               .id = NGCParam_abs_a },
-    { .name = "_abs_b",               .id = NGCParam_abs_b },
-    { .name = "_abs_c",               .id = NGCParam_abs_c },
-    { .name = "_abs_u",               .id = NGCParam_abs_u },
-    { .name = "_abs_v",               .id = NGCParam_abs_v },
-    { .name = "_abs_w",               .id = NGCParam_abs_w },
-    { .name = "_current_tool",        .id = NGCParam_current_tool },
-    { .name = "_current_pocket",      .id = NGCParam_current_pocket },
-    { .name = "_selected_tool",       .id = NGCParam_selected_tool },
-    { .name = "_selected_pocket",     .id = NGCParam_selected_pocket },
-    { .name = "_call_level",          .id = NGCParam_call_level },
-    { .name = "_probe_state",         .id = NGCParam_probe_state },
-    { .name = "_toolsetter_state",    .id = NGCParam_toolsetter_state }
+    { .name = "_x",                   .id = NGCParam_x },
+    { .name = "_y",                   .id = NGCParam_y },
+    { .name = "_z",                   .id = NGCParam_z }
 };
 
 // Named parameters
@@ -651,10 +735,28 @@ static char *ngc_name_tolower (char *s)
 	return name;
 }
 
+static const ngc_named_ro_param_t *ngc_named_ro_param_get (const char *name)
+{
+    int cmp;
+    uint_fast8_t lo = 0, hi = sizeof(ngc_named_ro_param) / sizeof(ngc_named_ro_param_t), mid;
+
+    while(lo < hi) {
+        mid = (lo + hi) >> 1;
+        if((cmp = strcmp(name, ngc_named_ro_param[mid].name)) == 0)
+            return &ngc_named_ro_param[mid];
+        if(cmp < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    return NULL;
+}
+
 bool ngc_named_param_get (char *name, float *value)
 {
     bool found = false;
-    uint_fast8_t idx = sizeof(ngc_named_ro_param) / sizeof(ngc_named_ro_param_t);
+    const ngc_named_ro_param_t *ro_param;
 
     name = ngc_name_tolower(name);
 
@@ -664,21 +766,14 @@ bool ngc_named_param_get (char *name, float *value)
 
     *value = 0.0f;
 
-     if(*name == '_') do {
-        idx--;
-        if((found = !strcmp(name, ngc_named_ro_param[idx].name)))
-            *value = ngc_named_param_get_by_id(ngc_named_ro_param[idx].id);
-    } while(idx && !found);
+    if(*name == '_' && (found = !!(ro_param = ngc_named_ro_param_get(name))))
+        *value = ngc_named_param_get_by_id(ro_param->id);
 
     if(!found) {
-        void *context = *name == '_' ? NULL : call_context;
-        ngc_named_rw_param_t *rw_param = rw_global_params;
-        while(rw_param && !found) {
-            if((found = rw_param->context == context && !strcmp(rw_param->name, name)))
-                *value = rw_param->value;
-            else
-                rw_param = rw_param->next;
-        }
+        ngc_named_rw_param_t *rw_param;
+        ngc_param_scope_t *scope = get_scope(*name == '_', false);
+        if(scope && (found = !!(rw_param = scope_get_named_param(scope, name, name_hash(name)))))
+            *value = rw_param->value;
     }
 
     return found;
@@ -694,7 +789,6 @@ bool ngc_named_param_exists (char *name)
 bool ngc_named_param_set (char *name, float value)
 {
     bool ok = false;
-    uint_fast8_t idx = sizeof(ngc_named_ro_param) / sizeof(ngc_named_ro_param_t);
 
     name = ngc_name_tolower(name);
 
@@ -703,39 +797,25 @@ bool ngc_named_param_set (char *name, float value)
         return false;
 
     // Check if it is a (read only) predefined parameter.
-    if(*name == '_') do {
-        idx--;
-        ok = !strcmp(name, ngc_named_ro_param[idx].name);
-    } while(idx && !ok);
+    if(*name == '_')
+        ok = !!ngc_named_ro_param_get(name);
 
     // If not predefined attempt to set it.
     if(!ok && (ok = strlen(name) <= NGC_MAX_PARAM_LENGTH)) {
 
-        void *context = *name == '_' ? NULL : call_context;
-        ngc_named_rw_param_t *rw_param = rw_global_params, *rw_param_last = rw_global_params;
-
-         while(rw_param) {
-             if(rw_param->context == context && !strcmp(rw_param->name, name)) {
-                 break;
-             } else {
-                 rw_param_last = rw_param;
-                 rw_param = rw_param->next;
-             }
-         }
-
-         if(rw_param == NULL && (rw_param = malloc(sizeof(ngc_named_rw_param_t)))) {
-             strcpy(rw_param->name, name);
-             rw_param->context = context;
-             rw_param->next = NULL;
-             if(rw_global_params == NULL)
-                 rw_global_params = rw_param;
-             else
-                 rw_param_last->next = rw_param;
-         }
-
-         if((ok = rw_param != NULL))
-             rw_param->value = value;
-     }
+        uint_fast8_t hash = name_hash(name);
+        ngc_named_rw_param_t *rw_param = NULL;
+        ngc_param_scope_t *scope = get_scope(*name == '_', true);
+
+        if(scope && (rw_param = scope_get_named_param(scope, name, hash)) == NULL && (rw_param = scope_alloc(scope, sizeof(ngc_named_rw_param_t)))) {
+            strcpy(rw_param->name, name);
+            rw_param->next = scope->named_params[hash];
+            scope->named_params[hash] = rw_param;
+        }
+
+        if((ok = rw_param != NULL))
+            rw_param->value = value;
+    }
 
     return ok;
 }
@@ -903,41 +983,10 @@ bool ngc_call_pop (void)
 {
     if(call_level >= 0) {
 
+        // Release all local parameters of the call level.
         if(call_context) {
-
-        ngc_rw_param_t *rw_param = rw_params, *rw_param_last = rw_params;
-
-        while(rw_param) {
-            if(rw_param->context == call_context) {
-                ngc_rw_param_t *rw_param_free = rw_param;
-                rw_param = rw_param->next;
-                if(rw_param_free == rw_params)
-                    rw_params = rw_param_last = rw_param;
-                else
-                    rw_param_last->next = rw_param;
-                free(rw_param_free);
-            } else {
-                rw_param_last = rw_param;
-                rw_param = rw_param->next;
-            }
-        }
-
-        ngc_named_rw_param_t *rw_named_param = rw_global_params, *rw_named_param_last = rw_global_params;
-
-        while(rw_named_param) {
-            if(rw_named_param->context == call_context) {
-                ngc_named_rw_param_t *rw_named_param_free = rw_named_param;
-                rw_named_param = rw_named_param->next;
-                if(rw_named_param_free == rw_global_params)
-                    rw_global_params = rw_named_param_last = rw_named_param;
-                else
-                    rw_named_param_last->next = rw_named_param;
-                free(rw_named_param_free);
-            } else {
-                rw_named_param_last = rw_named_param;
-                rw_named_param = rw_named_param->next;
-            }
-        }
+            scope_delete(call_levels[call_level].scope);
+            call_levels[call_level].scope = NULL;
         }
 
         if(call_levels[call_level].modal_state) {
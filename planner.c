@@ -46,7 +46,119 @@ static plan_block_t *block_buffer_head;                 // Pointer to the next b
 static plan_block_t *next_buffer_head;                  // Pointer to the next buffer head
 static plan_block_t *block_buffer_planned;              // Pointer to the optimally planned block
 
+// Velocity planning data, kept in a compact array parallel to the block buffer so that the planner passes
+// touches as little memory as possible. Entries are indexed by the block index in the buffer.
+// NOTE: An entry is 24 bytes, 32 bytes with ENABLE_JERK_ACCELERATION.
+typedef struct {
+    float entry_speed_sqr;
+    float max_entry_speed_sqr;
+    float acceleration;
+    float millimeters;
+    float nominal_speed;        // Nominal speed at the override generation nominal_gen.
+#if ENABLE_JERK_ACCELERATION
+    float max_acceleration;
+    float jerk;
+#endif
+    uint8_t override_gen;       // Override generation max_entry_speed_sqr was computed for.
+    uint8_t nominal_gen;        // Override generation nominal_speed was computed for.
+} plan_hot_t;
+
+static plan_hot_t *block_hot = NULL;
+static uint8_t override_gen = 0;                        // Incremented on feed and rapid override changes.
+
+#define block_index(block) ((uint_fast16_t)((block) - block_buffer))
+
+#if ENABLE_JERK_ACCELERATION
+
+/* Returns the square of the highest speed that can be reached from, or decelerated to, the given speed over
+   the given distance by a ramp starting and ending at zero acceleration at the block jerk and max acceleration.
+   This is the ramp executed by the stepper module, planning with it keeps the S-curves at the block jerk.
+   A ramp with speed change dv that is limited by the jerk j only covers d = (2v + dv) * sqrt(dv / j), a cubic
+   in s = sqrt(dv) that is solved in closed form. A ramp reaching the max acceleration a covers
+   d = (2v + dv) * (dv / a + a / j) / 2, a quadratic in dv.
+   NOTE: A call costs a cube root and up to three square roots, software routines on targets without a FPU. */
+static float plan_ramp_speed_sqr (const plan_hot_t *hot, float speed_sqr, float millimeters)
+{
+    if(millimeters <= 0.0f)
+        return speed_sqr;
+
+    float speed = sqrtf(speed_sqr), accel_sqr = hot->max_acceleration * hot->max_acceleration, delta_speed, u, w;
+    float r = millimeters * sqrtf(hot->jerk), p = 2.0f / 3.0f * speed;
+
+    // s^3 + 3p * s = r: s = u - w with u^3 - w^3 = r and u * w = p, rewritten to avoid cancellation.
+    u = cbrtf(0.5f * r + sqrtf(0.25f * r * r + p * p * p));
+    w = p / u;
+    delta_speed = r / (u * u + p + w * w);
+    delta_speed *= delta_speed;
+
+    if(delta_speed * hot->jerk > accel_sqr) {
+        float b = 2.0f * speed + accel_sqr / hot->jerk, c = 2.0f * (hot->max_acceleration * millimeters - speed * accel_sqr / hot->jerk);
+        delta_speed = 2.0f * c / (b + sqrtf(b * b + 4.0f * c));
+    }
+
+    speed += delta_speed;
+
+    return speed * speed;
+}
+
+#else
+
+// Returns the square of the highest speed that can be reached from, or decelerated to, the given speed over the given distance.
+static inline float plan_ramp_speed_sqr (const plan_hot_t *hot, float speed_sqr, float millimeters)
+{
+    return speed_sqr + 2.0f * hot->acceleration * millimeters;
+}
+
+#endif
+
+static inline uint_fast16_t block_index_prev (uint_fast16_t idx)
+{
+    return idx == 0 ? block_buffer_size : idx - 1;
+}
+
+static inline uint_fast16_t block_index_next (uint_fast16_t idx)
+{
+    return idx == block_buffer_size ? 0 : idx + 1;
+}
+
+static inline void plan_refresh_block (uint_fast16_t idx);
+
+#if PLANNER_RECALC_BUDGET
+
+static bool resume_pending = false;                     // Set when the reverse pass was cut short.
+static bool replan_all = false;                         // Set to replan the whole buffer on the next call.
+static uint_fast16_t resume_block;                      // The block to resume the reverse pass from.
+
+// Returns the position of a block in the buffer relative to the tail.
+static inline uint_fast16_t block_depth (uint_fast16_t idx)
+{
+    uint_fast16_t tail = block_index(block_buffer_tail);
+
+    return idx >= tail ? idx - tail : idx + block_buffer_size + 1 - tail;
+}
+
+#endif
+
+#if PLANNER_RECALC_STATS
+
+static struct {
+    uint32_t calls;
+    uint32_t max_blocks;
+    uint64_t blocks;
+} recalc_stats = {0};
+
+static uint_fast16_t recalc_blocks;
+
+#define recalc_count_block() recalc_blocks++;
+
+#else
+#define recalc_count_block()
+#endif
+
 static planner_t pl;
+#if ENABLE_PATH_BLENDING || ENABLE_LINE_MERGING
+static bool rebuilding = false;                         // Set while the end of the plan is rebuilt, defers replanning.
+#endif
 
 /*                            PLANNER SPEED DEFINITION
                                      +--------+   <- current->nominal_speed
@@ -113,66 +225,71 @@ static planner_t pl;
   look-ahead blocks numbering up to a hundred or more.
 
 */
-static void planner_recalculate (void)
+// Reverse pass, starting at block and ending before the planned block or when the budget is spent.
+// Returns the block the pass stopped at, the planned block if completed.
+static uint_fast16_t plan_reverse_pass (uint_fast16_t block, uint_fast16_t planned, uint_fast16_t *budget)
 {
-    // Initialize block pointer to the last block in the planner buffer.
-    plan_block_t *block = block_buffer_head->prev;
-
-    // Bail. Can't do anything with one only one plan-able block.
-    if (block == block_buffer_planned)
-        return;
-
-    // Reverse Pass: Coarsely maximize all possible deceleration curves back-planning from the last
-    // block in buffer. Cease planning when the last optimal planned or tail pointer is reached.
-    // NOTE: Forward pass will later refine and correct the reverse pass to create an optimal plan.
     float entry_speed_sqr;
-    plan_block_t *next;
-    plan_block_t *current = block;
-
-    // Calculate maximum entry speed for last block in buffer, where the exit speed is always zero.
-    current->entry_speed_sqr = min(current->max_entry_speed_sqr, 2.0f * current->acceleration * current->millimeters);
+    uint_fast16_t tail = block_index(block_buffer_tail), last = block_index_prev(block_index(block_buffer_head));
+    plan_hot_t *current;
 
-    block = block->prev;
-    if (block == block_buffer_planned) { // Only two plannable blocks in buffer. Reverse pass complete.
-        // Check if the first block is the tail. If so, notify stepper to update its current parameters.
-        if (block == block_buffer_tail)
-            st_update_plan_block_parameters(false);
-    } else while (block != block_buffer_planned) { // Three or more plan-able blocks
+    while (block != planned && *budget) {
 
-        next = current;
-        current = block;
-        block = block->prev;
+        plan_refresh_block(block);
+        current = &block_hot[block];
 
-        // Check if next block is the tail block(=planned block). If so, update current stepper parameters.
-        if (block == block_buffer_tail)
-            st_update_plan_block_parameters(false);
+        // Calculate maximum entry speed for last block in buffer, where the exit speed is always zero.
+        if (block == last)
+            current->entry_speed_sqr = min(current->max_entry_speed_sqr, plan_ramp_speed_sqr(current, 0.0f, current->millimeters));
 
         // Compute maximum entry speed decelerating over the current block from its exit speed.
-        if (current->entry_speed_sqr != current->max_entry_speed_sqr) {
-            entry_speed_sqr = next->entry_speed_sqr + 2.0f * current->acceleration * current->millimeters;
+        else if (current->entry_speed_sqr != current->max_entry_speed_sqr) {
+            entry_speed_sqr = plan_ramp_speed_sqr(current, block_hot[block_index_next(block)].entry_speed_sqr, current->millimeters);
             current->entry_speed_sqr = entry_speed_sqr < current->max_entry_speed_sqr ? entry_speed_sqr : current->max_entry_speed_sqr;
         }
+
+        block = block_index_prev(block);
+        (*budget)--;
+        recalc_count_block();
+
+        // Check if next block is the tail block(=planned block). If so, update current stepper parameters
+        // and pick up the entry speed it sets for the tail block, the forward pass plans from it.
+        if (block == tail) {
+            st_update_plan_block_parameters(false);
+            block_hot[tail].entry_speed_sqr = block_buffer_tail->entry_speed_sqr;
+        }
     }
 
-    // Forward Pass: Forward plan the acceleration curve from the planned pointer onward.
-    // Also scans for optimal plan breakpoints and appropriately updates the planned pointer.
-    next = block_buffer_planned; // Begin at buffer planned pointer
-    block = block_buffer_planned->next;
+    return block;
+}
+
+// Forward pass, starting at block and ending at the end block.
+// Returns the new planned block, moving it is only allowed when the pass starts at the planned block.
+static uint_fast16_t plan_forward_pass (uint_fast16_t block, uint_fast16_t end, uint_fast16_t planned)
+{
+    float entry_speed_sqr;
+    bool advance = block == planned;
+    plan_hot_t *current, *next = &block_hot[block];
 
-    while (block != block_buffer_head) {
+    block = block_index_next(block);
 
+    while (block != end) {
+
+        plan_refresh_block(block);
         current = next;
-        next = block;
+        next = &block_hot[block];
+        recalc_count_block();
 
         // Any acceleration detected in the forward pass automatically moves the optimal planned
         // pointer forward, since everything before this is all optimal. In other words, nothing
         // can improve the plan from the buffer tail to the planned pointer by logic.
         if (current->entry_speed_sqr < next->entry_speed_sqr) {
-            entry_speed_sqr = current->entry_speed_sqr + 2.0f * current->acceleration * current->millimeters;
+            entry_speed_sqr = plan_ramp_speed_sqr(current, current->entry_speed_sqr, current->millimeters);
         // If true, current block is full-acceleration and we can move the planned pointer forward.
             if (entry_speed_sqr < next->entry_speed_sqr) {
                 next->entry_speed_sqr = entry_speed_sqr; // Always <= max_entry_speed_sqr. Backward pass sets this.
-                block_buffer_planned = block; // Set optimal plan pointer.
+                if(advance)
+                    planned = block; // Set optimal plan pointer.
             }
         }
 
@@ -180,11 +297,97 @@ static void planner_recalculate (void)
         // point in the buffer. When the plan is bracketed by either the beginning of the
         // buffer and a maximum entry speed or two maximum entry speeds, every block in between
         // cannot logically be further improved. Hence, we don't have to recompute them anymore.
-        if (next->entry_speed_sqr == next->max_entry_speed_sqr)
-            block_buffer_planned = block;
+        if (advance && next->entry_speed_sqr == next->max_entry_speed_sqr)
+            planned = block;
 
-        block = block->next;
+        block = block_index_next(block);
     }
+
+    return planned;
+}
+
+static void planner_recalculate (void)
+{
+    // Initialize block index to the last block in the planner buffer.
+    uint_fast16_t block = block_index_prev(block_index(block_buffer_head)), planned = block_index(block_buffer_planned);
+
+    // Bail. Can't do anything with one only one plan-able block.
+    if (block == planned)
+        return;
+
+#if PLANNER_RECALC_STATS
+    recalc_blocks = 0;
+#endif
+
+    // The stepper module may have updated the entry speed and remaining distance of the tail block, refresh them.
+    if (block_buffer_planned == block_buffer_tail) {
+        block_hot[planned].entry_speed_sqr = block_buffer_tail->entry_speed_sqr;
+        block_hot[planned].millimeters = block_buffer_tail->millimeters;
+    }
+
+    // Reverse Pass: Coarsely maximize all possible deceleration curves back-planning from the last
+    // block in buffer. Cease planning when the last optimal planned or tail pointer is reached.
+    // NOTE: Forward pass will later refine and correct the reverse pass to create an optimal plan.
+    // Forward Pass: Forward plan the acceleration curve from the planned pointer onward.
+    // Also scans for optimal plan breakpoints and appropriately updates the planned pointer.
+#if PLANNER_RECALC_BUDGET
+
+    uint_fast16_t head = block_index(block_buffer_head);
+
+    // Drop the resume point if the planned block has moved past it or the block has been executed.
+    if (resume_pending && (replan_all || block_depth(resume_block) <= block_depth(planned) || block_depth(resume_block) >= block_depth(head)))
+        resume_pending = false;
+
+    // Split the budget between the end of the buffer and resuming the previous pass, if any.
+    uint_fast16_t budget = replan_all ? block_buffer_size + 1 : (resume_pending ? (PLANNER_RECALC_BUDGET + 1) / 2 : PLANNER_RECALC_BUDGET);
+    uint_fast16_t stop = plan_reverse_pass(block, planned, &budget);
+
+    replan_all = false;
+
+    if (stop == planned) {
+        resume_pending = false;
+        planned = plan_forward_pass(planned, head, planned);
+    } else {
+        // Budget spent before reaching the planned block. Blocks not processed keep their earlier
+        // planned entry speeds, these are lower and always safe. Forward plan the processed range.
+        plan_forward_pass(stop, head, planned);
+
+        if (!resume_pending || block_depth(resume_block) >= block_depth(stop))
+            resume_block = stop;
+        else {
+            // Continue the earlier pass towards the planned block, the exit speed of the resume block
+            // may be lower than possible but it is safe.
+            uint_fast16_t resume = resume_block;
+
+            budget = PLANNER_RECALC_BUDGET / 2;
+            resume_block = plan_reverse_pass(resume, planned, &budget);
+            planned = plan_forward_pass(resume_block, block_index_next(resume), planned);
+
+            // Start a new sweep from the end of the buffer when the planned block was reached.
+            if (resume_block == block_index(block_buffer_planned))
+                resume_block = stop;
+        }
+
+        resume_pending = true;
+    }
+
+#else
+
+    uint_fast16_t budget = block_buffer_size + 1;
+
+    plan_reverse_pass(block, planned, &budget);
+    planned = plan_forward_pass(planned, block_index(block_buffer_head), planned);
+
+#endif
+
+    block_buffer_planned = &block_buffer[planned];
+
+#if PLANNER_RECALC_STATS
+    recalc_stats.calls++;
+    recalc_stats.blocks += recalc_blocks;
+    if (recalc_blocks > recalc_stats.max_blocks)
+        recalc_stats.max_blocks = recalc_blocks;
+#endif
 }
 
 inline static void plan_cleanup (plan_block_t *block)
@@ -211,8 +414,30 @@ inline static void plan_reset_buffer (void)
     block_buffer_tail = block_buffer_head = block_buffer;   // Empty = tail == head
     next_buffer_head = block_buffer_head->next;             // = next block
     block_buffer_planned = block_buffer_tail;               // = block_buffer_tail
+#if PLANNER_RECALC_BUDGET
+    resume_pending = replan_all = false;
+#endif
 }
 
+#if PLANNER_RECALC_STATS
+
+static status_code_t report_recalc_stats (sys_state_t state, char *args)
+{
+    hal.stream.write("[PLANNERSTATS:");
+    hal.stream.write(uitoa(recalc_stats.calls));
+    hal.stream.write(",");
+    hal.stream.write(ftoa(recalc_stats.calls ? (float)recalc_stats.blocks / (float)recalc_stats.calls : 0.0f, 1));
+    hal.stream.write(",");
+    hal.stream.write(uitoa(recalc_stats.max_blocks));
+    hal.stream.write("]" ASCII_EOL);
+
+    memset(&recalc_stats, 0, sizeof(recalc_stats));
+
+    return Status_OK;
+}
+
+#endif
+
 uint_fast16_t plan_get_buffer_size (void)
 {
     return block_buffer_size;
@@ -224,13 +449,30 @@ bool plan_reset (void)
 
         block_buffer_size = settings.planner_buffer_blocks;
 
-        while((block_buffer = malloc((block_buffer_size + 1) * sizeof(plan_block_t))) == NULL) {
+        while((block_buffer = malloc((block_buffer_size + 1) * (sizeof(plan_block_t) + sizeof(plan_hot_t)))) == NULL) {
             if(block_buffer_size > 40)
                 block_buffer_size -= block_buffer_size >= 250 ? 100 : 10;
             else
                 break;
         }
 
+        if(block_buffer)
+            block_hot = (plan_hot_t *)&block_buffer[block_buffer_size + 1];
+
+#if PLANNER_RECALC_STATS
+
+        static const sys_command_t planner_command_list[] = {
+            {"PLANNERSTATS", report_recalc_stats, { .noargs = On, .allow_blocking = On }, { .str = "output and reset number of planner calls, mean and max blocks processed per call" } }
+        };
+
+        static sys_commands_t planner_commands = {
+            .n_commands = sizeof(planner_command_list) / sizeof(sys_command_t),
+            .commands = planner_command_list
+        };
+
+        system_register_commands(&planner_commands);
+#endif
+
         if(block_buffer_size != settings.planner_buffer_blocks)
             task_run_on_startup(report_plain, "Planner buffer size was reduced!");
     }
@@ -248,6 +490,9 @@ bool plan_reset (void)
     }
 
     memset(&pl, 0, sizeof(planner_t)); // Clear planner struct
+#if ENABLE_PATH_BLENDING || ENABLE_LINE_MERGING
+    rebuilding = false;
+#endif
 
     // Set up stepper block ringbuffer as circular doubly linked list
     uint_fast8_t idx;
@@ -270,6 +515,9 @@ void plan_discard_current_block (void)
         if (block_buffer_tail == block_buffer_planned)
             block_buffer_planned = block_buffer_tail->next;
         block_buffer_tail = block_buffer_tail->next;
+        // Hand the planned entry speed over to the stepper module.
+        if (block_buffer_tail != block_buffer_head)
+            block_buffer_tail->entry_speed_sqr = block_hot[block_index(block_buffer_tail)].entry_speed_sqr;
     }
 }
 
@@ -291,7 +539,7 @@ plan_block_t *plan_get_current_block (void)
 inline float plan_get_exec_block_exit_speed_sqr (void)
 {
     plan_block_t *block = block_buffer_tail->next;
-    return block == block_buffer_head ? 0.0f : block->entry_speed_sqr;
+    return block == block_buffer_head ? 0.0f : block_hot[block_index(block)].entry_speed_sqr;
 }
 
 
@@ -333,9 +581,48 @@ inline static float plan_compute_profile_parameters (plan_block_t *block, float
     if (block->max_entry_speed_sqr > block->max_junction_speed_sqr)
         block->max_entry_speed_sqr = block->max_junction_speed_sqr;
 
+    plan_hot_t *hot = &block_hot[block_index(block)];
+
+    hot->max_entry_speed_sqr = block->max_entry_speed_sqr;
+    hot->acceleration = block->acceleration;
+    hot->millimeters = block->millimeters;
+#if ENABLE_JERK_ACCELERATION
+    hot->max_acceleration = block->max_acceleration;
+    hot->jerk = block->jerk;
+#endif
+    hot->nominal_speed = nominal_speed;
+    hot->override_gen = hot->nominal_gen = override_gen;
+
     return nominal_speed;
 }
 
+// Returns the nominal speed of a block for the current overrides, computed once per override change.
+static inline float plan_nominal_speed (uint_fast16_t idx)
+{
+    plan_hot_t *hot = &block_hot[idx];
+
+    if(hot->nominal_gen != override_gen) {
+        hot->nominal_speed = plan_compute_profile_nominal_speed(&block_buffer[idx]);
+        hot->nominal_gen = override_gen;
+    }
+
+    return hot->nominal_speed;
+}
+
+// Recomputes the max entry speed of a block if overrides has changed since it was last computed.
+// The nominal speed of the previous block is cached for when the reverse pass reaches it.
+// NOTE: The result is the same as when computed for all blocks in the buffer on the override change.
+static inline void plan_refresh_block (uint_fast16_t idx)
+{
+    if(block_hot[idx].override_gen != override_gen) {
+
+        plan_block_t *block = &block_buffer[idx];
+
+        plan_compute_profile_parameters(block, plan_nominal_speed(idx),
+                                         block == block_buffer_tail ? SOME_LARGE_VALUE : plan_nominal_speed(block_index_prev(idx)));
+    }
+}
+
 static inline float limit_acceleration_by_axis_maximum (float *unit_vec)
 {
     uint_fast8_t idx = N_AXIS;
@@ -364,6 +651,30 @@ static inline float limit_jerk_by_axis_maximum (float *unit_vec)
 }
 #endif
 
+#if ENABLE_AXIS_JUNCTION_LIMITS
+
+// Returns the junction speed that keeps the velocity change of each axis at the junction within
+// what the axis can do in a jerk limited ramp up to max acceleration and back down to zero.
+// Returns 0 if an axis changing velocity has no jerk setting, junction deviation is then used.
+static float axis_junction_speed (float *junction_unit_vec)
+{
+    uint_fast8_t idx = N_AXIS;
+    float junction_speed = SOME_LARGE_VALUE;
+
+    do {
+        if(junction_unit_vec[--idx] != 0.0f) {
+            if(settings.axis[idx].jerk <= 0.0f)
+                return 0.0f;
+            junction_speed = min(junction_speed, settings.axis[idx].acceleration * settings.axis[idx].acceleration /
+                                                  (settings.axis[idx].jerk * fabsf(junction_unit_vec[idx])));
+        }
+    } while(idx);
+
+    return junction_speed;
+}
+
+#endif
+
 static inline float limit_max_rate_by_axis_maximum (float *unit_vec)
 {
     uint_fast8_t idx = N_AXIS;
@@ -377,6 +688,312 @@ static inline float limit_max_rate_by_axis_maximum (float *unit_vec)
     return limit_value;
 }
 
+#if ENABLE_NATIVE_ARCS
+
+// Copies the arc geometry to the block, computes the arc length and the maximum number of steps
+// any axis can move along the arc. delta[] is the linear distance moved by each axis.
+static void plan_arc_init (plan_block_t *block, plan_arc_t *arc, int32_t *start_steps, int32_t *target_steps, float *delta)
+{
+    uint_fast8_t idx = N_AXIS;
+    float travel = fabsf(arc->angular_travel) * arc->radius, max_steps = 0.0f;
+
+    memcpy(&block->arc, arc, sizeof(plan_arc_t));
+    memcpy(block->arc.start_steps, start_steps, sizeof(block->arc.start_steps));
+    memcpy(block->arc.target_steps, target_steps, sizeof(block->arc.target_steps));
+
+    block->arc.millimeters = travel * travel;
+
+    do {
+        idx--;
+        if(idx == arc->axis_0 || idx == arc->axis_1)
+            max_steps = max(max_steps, travel * settings.axis[idx].steps_per_mm);
+        else if(delta[idx] != 0.0f) {
+            block->arc.millimeters += delta[idx] * delta[idx];
+            max_steps = max(max_steps, fabsf(delta[idx]) * settings.axis[idx].steps_per_mm);
+        }
+    } while(idx);
+
+    block->arc.millimeters = sqrtf(block->arc.millimeters);
+    block->step_event_count = (uint32_t)ceilf(max_steps);
+}
+
+// Computes the unit vector of the arc tangent at the given angle from the arc start.
+static void plan_arc_tangent (plan_arc_t *arc, float angle, float *unit_vec)
+{
+    uint_fast8_t idx = N_AXIS;
+    float scale = arc->angular_travel / arc->millimeters, cos_a = cosf(angle), sin_a = sinf(angle);
+
+    do {
+        idx--;
+        unit_vec[idx] = (float)(arc->target_steps[idx] - arc->start_steps[idx]) / (settings.axis[idx].steps_per_mm * arc->millimeters);
+    } while(idx);
+
+    unit_vec[arc->axis_0] = -(arc->radius_vec[0] * sin_a + arc->radius_vec[1] * cos_a) * scale;
+    unit_vec[arc->axis_1] = (arc->radius_vec[0] * cos_a - arc->radius_vec[1] * sin_a) * scale;
+}
+
+// Sets the axis limits vector for the arc, each arc plane axis may move at full speed along the arc.
+static void plan_arc_limits_vector (plan_arc_t *arc, float *unit_vec)
+{
+    plan_arc_tangent(arc, 0.0f, unit_vec);
+
+    unit_vec[arc->axis_0] = unit_vec[arc->axis_1] = fabsf(arc->angular_travel) * arc->radius / arc->millimeters;
+}
+
+#endif
+
+#if ENABLE_PATH_BLENDING || ENABLE_LINE_MERGING
+
+static inline bool is_blendable (planner_cond_t condition)
+{
+    return !(condition.rapid_motion || condition.system_motion || condition.jog_motion || condition.backlash_motion || condition.arc_motion ||
+              condition.inverse_time || condition.units_per_rev);
+}
+
+#endif
+
+#if ENABLE_LINE_MERGING
+
+/* Merges a new move into the last block in the buffer if it continues in the same direction and the
+   accumulated deviation from the path of the moves merged stays within the tolerance.
+   The block is replanned from its start position to the new target, this is only done if
+   its entry speed will not be lowered so that the existing plan stays valid.
+   NOTE: Line numbers are not compared, the block takes the line number of the new move
+         and the line number reported while it is executed is that of the last move merged. */
+static bool plan_merge_line (float *target, plan_line_data_t *pl_data)
+{
+    plan_block_t *prev = block_buffer_head->prev;
+
+#ifdef KINEMATICS_API
+    return false; // Planner position is in motor steps, not cartesian coordinates.
+#endif
+
+    if(pl_data->control != ControlMode_PathBlending || block_buffer_head == block_buffer_tail || prev == block_buffer_tail ||
+        pl_data->message || pl_data->output_commands || pl_data->spindle.css || pl_data->spindle.state.synchronized ||
+         !is_blendable(pl_data->condition) || !is_blendable(prev->condition) || prev->spindle.css || prev->message || prev->output_commands ||
+          prev->condition.value != pl_data->condition.value || prev->overrides.value != pl_data->overrides.value ||
+           prev->offset_id != pl_data->offset_id || prev->programmed_rate != pl_data->feed_rate ||
+            prev->spindle.hal != pl_data->spindle.hal || prev->spindle.state.value != pl_data->spindle.state.value ||
+             prev->spindle.rpm != pl_data->spindle.rpm)
+        return false;
+
+#if ENABLE_ACCELERATION_PROFILES
+    if(prev->acceleration_factor != pl_data->acceleration_factor)
+        return false;
+#endif
+
+#if ENABLE_ADAPTIVE_SPLINES
+    if(pl_data->max_rate > 0.0f)
+        return false; // The rate limit of the last block is lost when replanned.
+#endif
+
+    uint_fast8_t idx = N_AXIS;
+    int32_t start_steps[N_AXIS];
+    float tolerance = LINE_MERGE_TOLERANCE, line[N_AXIS], corner[N_AXIS], length_sqr = 0.0f, dot = 0.0f, deviation = 0.0f;
+
+#if ENABLE_PATH_BLENDING
+    if(pl_data->cam_tolerance > 0.0f)
+        tolerance = pl_data->cam_tolerance;
+#endif
+
+    // Vector from block start to the new target and from block start to the current end of the block.
+    do {
+        idx--;
+        start_steps[idx] = pl.position[idx] + (prev->direction.bits & bit(idx) ? (int32_t)prev->steps.value[idx] : -(int32_t)prev->steps.value[idx]);
+        line[idx] = (float)(lroundf(target[idx] * settings.axis[idx].steps_per_mm) - start_steps[idx]) / settings.axis[idx].steps_per_mm;
+        corner[idx] = (float)(pl.position[idx] - start_steps[idx]) / settings.axis[idx].steps_per_mm;
+        length_sqr += line[idx] * line[idx];
+        dot += line[idx] * corner[idx];
+        deviation += corner[idx] * corner[idx];
+    } while(idx);
+
+    // The current end of the block has to be between the start and the new target, this rejects reversals.
+    if(dot <= 0.0f || dot >= length_sqr)
+        return false;
+
+    // Distance from the current end of the block to the new line, the deviation of points merged
+    // earlier changes by no more than this.
+    deviation = sqrtf(max(deviation - dot * dot / length_sqr, 0.0f)) + pl.merge_deviation;
+
+    if(deviation > tolerance)
+        return false;
+
+    plan_block_t prev_block;
+    plan_hot_t *hot = &block_hot[block_index(prev)], prev_hot;
+    planner_t pl_saved;
+    plan_block_t *head = block_buffer_head, *next_head = next_buffer_head;
+
+    memcpy(&prev_block, prev, sizeof(plan_block_t));
+    memcpy(&prev_hot, hot, sizeof(plan_hot_t));
+    memcpy(&pl_saved, &pl, sizeof(planner_t));
+
+    // Rewind the buffer and the planner state to the start of the last block and plan it again.
+    block_buffer_head = prev;
+    next_buffer_head = head;
+    memcpy(pl.position, start_steps, sizeof(pl.position));
+    memcpy(pl.previous_unit_vec, pl.merge_unit_vec, sizeof(pl.previous_unit_vec));
+    // Overrides may have changed since the block was added, the nominal speed of the block before it is recomputed.
+    pl.previous_nominal_speed = plan_compute_profile_nominal_speed(prev->prev);
+
+    rebuilding = true;
+
+    bool ok;
+    plan_line_data_t pl_merge;
+
+    memcpy(&pl_merge, pl_data, sizeof(plan_line_data_t));
+
+    if((ok = plan_buffer_line(target, &pl_merge))) {
+        // The new entry speed limit may differ slightly as the direction has changed,
+        // check that the entry speed already planned can be kept.
+        ok = prev_hot.entry_speed_sqr <= hot->max_entry_speed_sqr &&
+              prev_hot.entry_speed_sqr <= plan_ramp_speed_sqr(hot, 0.0f, hot->millimeters);
+    }
+
+    rebuilding = false;
+
+    if(ok) {
+        pl.merge_deviation = deviation;
+        hot->entry_speed_sqr = prev_hot.entry_speed_sqr;
+        planner_recalculate();
+    } else {
+        // Restore the plan, the caller adds the move as is.
+        memcpy(prev, &prev_block, sizeof(plan_block_t) - 2 * sizeof(plan_block_t *));
+        memcpy(hot, &prev_hot, sizeof(plan_hot_t));
+        memcpy(&pl, &pl_saved, sizeof(planner_t));
+        block_buffer_head = head;
+        next_buffer_head = next_head;
+    }
+
+    return ok;
+}
+
+#endif // ENABLE_LINE_MERGING
+
+#if ENABLE_PATH_BLENDING
+
+/* Replaces the corner between the last block in the buffer and a new G64 P move with a chord,
+   cutting the corner no more than the path tolerance. The last block is shortened and
+   the chord and the new move are added behind it, halving the direction change at each junction.
+   The corner is left as is if the last block may be executing, if the new move carries data that
+   has to be executed at the corner, or if the resulting plan could lower the entry speed of the
+   last block. The latter ensures the existing plan stays valid, as is the case when a block is added.
+   NOTE: Requires room for two blocks in the buffer. */
+static bool plan_blend_corner (float *target, plan_line_data_t *pl_data)
+{
+    plan_block_t *prev = block_buffer_head->prev;
+
+#ifdef KINEMATICS_API
+    return false; // Planner position is in motor steps, not cartesian coordinates.
+#endif
+
+    if(block_buffer_head == block_buffer_tail || prev == block_buffer_tail || plan_get_block_buffer_available() < 3 ||
+        pl_data->message || pl_data->output_commands || pl_data->spindle.css || pl_data->spindle.state.synchronized ||
+         !is_blendable(pl_data->condition) || !is_blendable(prev->condition) || prev->spindle.css ||
+          prev->offset_id != pl_data->offset_id || prev->spindle.state.value != pl_data->spindle.state.value ||
+           prev->spindle.rpm != pl_data->spindle.rpm)
+        return false;
+
+    uint_fast8_t idx = N_AXIS;
+    int32_t start_steps[N_AXIS];
+    float corner[N_AXIS], unit_vec[N_AXIS], point[N_AXIS], length, cos_theta = 0.0f, sin_theta_d2, distance;
+
+    do {
+        idx--;
+        corner[idx] = (float)pl.position[idx] / settings.axis[idx].steps_per_mm;
+        unit_vec[idx] = (float)(lroundf(target[idx] * settings.axis[idx].steps_per_mm) - pl.position[idx]) / settings.axis[idx].steps_per_mm;
+    } while(idx);
+
+    if((length = convert_delta_vector_to_unit_vector(unit_vec)) == 0.0f)
+        return false;
+
+    idx = N_AXIS;
+    do {
+        idx--;
+        cos_theta += pl.previous_unit_vec[idx] * unit_vec[idx];
+    } while(idx);
+
+    // Skip near straight junctions, nothing to gain, and reversals.
+    if(cos_theta > 0.9999f || cos_theta < -0.95f)
+        return false;
+
+    // The distance from the corner to the chord is the distance along the lines from the corner
+    // to the chord end points times the sine of half the direction change.
+    sin_theta_d2 = sqrtf(0.5f * (1.0f - cos_theta));
+    distance = min(pl_data->path_tolerance / sin_theta_d2, 0.5f * min(length, prev->millimeters));
+
+    plan_block_t prev_block;
+    planner_t pl_saved;
+    plan_block_t *head = block_buffer_head, *next_head = next_buffer_head;
+
+    memcpy(&prev_block, prev, sizeof(plan_block_t));
+    memcpy(&pl_saved, &pl, sizeof(planner_t));
+
+    // Shorten the last block, the chord starts where it now ends.
+    prev->step_event_count = 0;
+    idx = N_AXIS;
+    do {
+        idx--;
+        start_steps[idx] = pl.position[idx] + (prev->direction.bits & bit(idx) ? (int32_t)prev->steps.value[idx] : -(int32_t)prev->steps.value[idx]);
+        pl.position[idx] = lroundf((corner[idx] - distance * pl.previous_unit_vec[idx]) * settings.axis[idx].steps_per_mm);
+        prev->steps.value[idx] = labs(pl.position[idx] - start_steps[idx]);
+        prev->step_event_count = max(prev->step_event_count, prev->steps.value[idx]);
+        point[idx] = (float)(pl.position[idx] - start_steps[idx]) / settings.axis[idx].steps_per_mm;
+    } while(idx);
+
+    block_hot[block_index(prev)].millimeters = prev->millimeters = convert_delta_vector_to_unit_vector(point);
+
+    rebuilding = true;
+
+    idx = N_AXIS;
+    do {
+        idx--;
+        point[idx] = corner[idx] + distance * unit_vec[idx];
+    } while(idx);
+
+    bool ok;
+    plan_line_data_t pl_chord;
+
+    // NOTE: plan_buffer_line() may modify the feed rate, use a fresh copy of the line data for each block.
+    memcpy(&pl_chord, pl_data, sizeof(plan_line_data_t));
+
+    if((ok = prev->step_event_count != 0 && plan_buffer_line(point, &pl_chord))) {
+        memcpy(&pl_chord, pl_data, sizeof(plan_line_data_t));
+        ok = plan_buffer_line(target, &pl_chord);
+    }
+
+    if(ok) {
+
+        plan_block_t *chord = prev->next, *block = chord->next;
+
+        // Check that the planned entry speed of the shortened block will not be lowered by replanning,
+        // it must be able to decelerate from it to the lowest speed the chord may be entered at.
+        plan_hot_t *hot = &block_hot[block_index(block)];
+        float entry_speed_sqr = min(block->max_entry_speed_sqr, plan_ramp_speed_sqr(hot, 0.0f, block->millimeters));
+
+        hot = &block_hot[block_index(chord)];
+        entry_speed_sqr = min(chord->max_entry_speed_sqr, plan_ramp_speed_sqr(hot, entry_speed_sqr, chord->millimeters));
+
+        hot = &block_hot[block_index(prev)];
+        ok = plan_ramp_speed_sqr(hot, entry_speed_sqr, prev->millimeters) >= hot->entry_speed_sqr;
+    }
+
+    rebuilding = false;
+
+    if(ok)
+        planner_recalculate();
+    else {
+        // Restore the plan, the caller adds the move as is.
+        memcpy(prev, &prev_block, sizeof(plan_block_t) - 2 * sizeof(plan_block_t *));
+        block_hot[block_index(prev)].millimeters = prev->millimeters;
+        memcpy(&pl, &pl_saved, sizeof(planner_t));
+        block_buffer_head = head;
+        next_buffer_head = next_head;
+    }
+
+    return ok;
+}
+
+#endif // ENABLE_PATH_BLENDING
 
 /* Add a new linear movement to the buffer. target[N_AXIS] is the signed, absolute target position
    in millimeters. Feed rate specifies the speed of the motion. If feed rate is inverted, the feed
@@ -405,6 +1022,19 @@ bool plan_buffer_line (float *target, plan_line_data_t *pl_data)
     axes_signals_t motion = {0};
 #endif
 
+#if ENABLE_PATH_BLENDING || ENABLE_LINE_MERGING
+    if(!rebuilding) {
+  #if ENABLE_LINE_MERGING
+        if(plan_merge_line(target, pl_data))
+            return true;
+  #endif
+  #if ENABLE_PATH_BLENDING
+        if(pl_data->path_tolerance > 0.0f && plan_blend_corner(target, pl_data))
+            return true;
+  #endif
+    }
+#endif
+
 //    plan_cleanup(block);
     memset(block, 0, sizeof(plan_block_t) - 2 * sizeof(plan_block_t *));    // Zero all block values (except linked list pointers).
     memcpy(&block->spindle, &pl_data->spindle, sizeof(spindle_t));          // Copy spindle data (RPM etc)
@@ -448,6 +1078,11 @@ bool plan_buffer_line (float *target, plan_line_data_t *pl_data)
 
     block->direction = direction;
 
+#if ENABLE_NATIVE_ARCS
+    if(block->condition.arc_motion)
+        plan_arc_init(block, pl_data->arc, position_steps, target_steps, unit_vec);
+#endif
+
     // Calculate RPMs to be used for Constant Surface Speed (CSS) calculations.
     if(block->spindle.css) {
 
@@ -516,6 +1151,12 @@ bool plan_buffer_line (float *target, plan_line_data_t *pl_data)
     // if they are also orthogonal/independent. Operates on the absolute value of the unit vector.
 #endif
 
+#if ENABLE_NATIVE_ARCS
+    if(block->condition.arc_motion) {
+        block->millimeters = block->arc.millimeters;
+        plan_arc_limits_vector(&block->arc, unit_vec);
+    } else
+#endif
     block->millimeters = convert_delta_vector_to_unit_vector(unit_vec);
 #if ENABLE_JERK_ACCELERATION
     block->max_acceleration = limit_acceleration_by_axis_maximum(unit_vec);
@@ -537,6 +1178,23 @@ bool plan_buffer_line (float *target, plan_line_data_t *pl_data)
 #endif
 #endif
 
+#if ENABLE_NATIVE_ARCS
+    if(block->condition.arc_motion) {
+        // Limit speed by the centripetal acceleration the arc plane axes can handle.
+        float acceleration = min(settings.axis[block->arc.axis_0].acceleration, settings.axis[block->arc.axis_1].acceleration);
+  #if ENABLE_ACCELERATION_PROFILES
+        acceleration *= block->acceleration_factor;
+  #endif
+        block->rapid_rate = min(block->rapid_rate, sqrtf(acceleration * block->arc.radius) / unit_vec[block->arc.axis_0]);
+        plan_arc_tangent(&block->arc, 0.0f, unit_vec); // Entry direction for the junction speed calculation.
+    }
+#endif
+
+#if ENABLE_ADAPTIVE_SPLINES
+    if(pl_data->max_rate > 0.0f)
+        block->rapid_rate = min(block->rapid_rate, pl_data->max_rate);
+#endif
+
     // Store programmed rate.
     if (block->condition.rapid_motion)
         block->programmed_rate = block->rapid_rate;
@@ -613,20 +1271,45 @@ bool plan_buffer_line (float *target, plan_line_data_t *pl_data)
             // Junction is a straight line or 180 degrees. Junction speed is infinite.
             block->max_junction_speed_sqr = SOME_LARGE_VALUE;
         } else {
+#if ENABLE_AXIS_JUNCTION_LIMITS
+            float junction_speed = axis_junction_speed(junction_unit_vec);
+            if(junction_speed > 0.0f) {
+  #if ENABLE_ACCELERATION_PROFILES
+                junction_speed *= block->acceleration_factor * block->acceleration_factor; // Scales with acceleration squared.
+  #endif
+                block->max_junction_speed_sqr = max(MINIMUM_JUNCTION_SPEED * MINIMUM_JUNCTION_SPEED, junction_speed * junction_speed);
+            } else {
+#endif
             convert_delta_vector_to_unit_vector(junction_unit_vec);
             float junction_acceleration = limit_acceleration_by_axis_maximum(junction_unit_vec);
             float sin_theta_d2 = sqrtf(0.5f * (1.0f - junction_cos_theta)); // Trig half angle identity. Always positive.
             block->max_junction_speed_sqr = max(MINIMUM_JUNCTION_SPEED * MINIMUM_JUNCTION_SPEED,
                                                   (junction_acceleration * settings.junction_deviation * sin_theta_d2) / (1.0f - sin_theta_d2));
+#if ENABLE_AXIS_JUNCTION_LIMITS
+            }
+#endif
         }
     }
 
     // Block system motion from updating this data to ensure next g-code motion is computed correctly.
     if (!block->condition.system_motion) {
 
+#if ENABLE_LINE_MERGING
+        if(!block->condition.backlash_motion) {
+            // Keep the data needed to replan the block when merging the next move into it.
+            memcpy(pl.merge_unit_vec, pl.previous_unit_vec, sizeof(pl.merge_unit_vec));
+            pl.merge_deviation = 0.0f;
+        }
+#endif
+
         pl.previous_nominal_speed = plan_compute_profile_parameters(block, plan_compute_profile_nominal_speed(block), pl.previous_nominal_speed);
+        block_hot[block_index(block)].entry_speed_sqr = block->entry_speed_sqr;
 
         if(!block->condition.backlash_motion) {
+#if ENABLE_NATIVE_ARCS
+            if(block->condition.arc_motion)
+                plan_arc_tangent(&block->arc, block->arc.angular_travel, unit_vec); // Exit direction.
+#endif
             // Update previous path unit_vector and planner position.
             memcpy(pl.previous_unit_vec, unit_vec, sizeof(unit_vec)); // pl.previous_unit_vec[] = unit_vec[]
             memcpy(pl.position, target_steps, sizeof(target_steps)); // pl.position[] = target_steps[]
@@ -636,6 +1319,9 @@ bool plan_buffer_line (float *target, plan_line_data_t *pl_data)
         next_buffer_head = block_buffer_head->next;
 
         // Finish up by recalculating the plan with the new block.
+#if ENABLE_PATH_BLENDING || ENABLE_LINE_MERGING
+        if(!rebuilding)
+#endif
         planner_recalculate();
     }
 
@@ -684,24 +1370,23 @@ void plan_cycle_reinitialize (void)
 {
     // Re-plan from a complete stop. Reset planner entry speeds and buffer planned pointer.
     st_update_plan_block_parameters(false);
+#if PLANNER_RECALC_BUDGET
+    replan_all = true; // Entry speed limits may have been lowered, do not leave any block unprocessed.
+#endif
     if((block_buffer_planned = block_buffer_tail) != block_buffer_head)
         planner_recalculate();
 }
 
-// Re-calculates buffered motions profile parameters upon a motion-based override change.
+// Invalidates buffered motions profile parameters upon a motion-based override change.
+// The max entry speed of each block is recomputed when the planner next processes it, the stepper module
+// always computes the nominal speed of the block being executed.
+// NOTE: plan_cycle_reinitialize() replans the whole buffer after an override change, the recompute is done
+//       in that pass instead of in a separate walk over the buffer.
 static bool plan_update_velocity_profile_parameters (void)
 {
     if(block_buffer_tail != block_buffer_head) {
-
-        plan_block_t *block = block_buffer_tail;
-        float prev_nominal_speed = SOME_LARGE_VALUE; // Set high for first block nominal speed calculation.
-
-        while (block != block_buffer_head) {
-            prev_nominal_speed = plan_compute_profile_parameters(block, plan_compute_profile_nominal_speed(block), prev_nominal_speed);
-            block = block->next;
-        }
-
-        pl.previous_nominal_speed = prev_nominal_speed; // Update prev nominal speed for next incoming block.
+        override_gen++;
+        pl.previous_nominal_speed = plan_compute_profile_nominal_speed(block_buffer_head->prev); // Update prev nominal speed for next incoming block.
     }
 
     return block_buffer_tail != block_buffer_head;
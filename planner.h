@@ -38,7 +38,8 @@ typedef union {
                  is_laser_ppi_mode    :1,
                  target_valid         :1,
                  target_validated     :1,
-                 unassigned           :5;
+                 arc_motion           :1,
+                 unassigned           :4;
         coolant_state_t coolant;
     };
 } planner_cond_t;
@@ -67,6 +68,23 @@ typedef union {
     };
 } steps_t;
 
+#if ENABLE_NATIVE_ARCS
+
+// Circular or helical arc geometry for arcs executed by the segment generator.
+typedef struct {
+    float center[2];                // Arc center in the arc plane (mm)
+    float radius_vec[2];            // Vector from the arc center to the start position (mm)
+    float radius;                   // Arc radius (mm)
+    float angular_travel;           // Signed angular travel, positive for CCW arcs (radians)
+    float millimeters;              // Total arc length (mm). Set by the planner.
+    int32_t start_steps[N_AXIS];    // Start position in absolute steps. Set by the planner.
+    int32_t target_steps[N_AXIS];   // Target position in absolute steps. Set by the planner.
+    uint8_t axis_0;                 // First axis of the arc plane
+    uint8_t axis_1;                 // Second axis of the arc plane
+} plan_arc_t;
+
+#endif
+
 // This struct stores a linear movement of a g-code block motion with its critical "nominal" values
 // are as specified in the source g-code.
 typedef struct plan_block {
@@ -84,6 +102,8 @@ typedef struct plan_block {
 
     // Fields used by the motion planner to manage acceleration. Some of these values may be updated
     // by the stepper module during execution of special motion cases for replanning purposes.
+    // NOTE: The planner works on a copy of these kept in a separate array, entry_speed_sqr is only
+    //       valid for the block at the buffer tail, the block being executed.
     float entry_speed_sqr;          // The current planned entry speed at block junction in (mm/min)^2
     float max_entry_speed_sqr;      // Maximum allowable entry speed based on the minimum of junction limit and
                                     // neighboring nominal speeds with overrides in (mm/min)^2
@@ -107,6 +127,9 @@ typedef struct plan_block {
 #endif
     // Stored spindle speed data used by spindle overrides and resuming methods.
     spindle_t spindle;              // Block spindle parameters. Copied from pl_line_data.
+#if ENABLE_NATIVE_ARCS
+    plan_arc_t arc;                 // Arc geometry, only valid when condition.arc_motion is set.
+#endif
 
     char *message;                  // Message to be displayed when block is executed.
     output_command_t *output_commands;
@@ -126,12 +149,21 @@ typedef struct {
 #if ENABLE_PATH_BLENDING
     float path_tolerance;           //!< Path blending tolerance.
     float cam_tolerance;            //!< Naive CAM tolerance.
+#endif
+#if ENABLE_LINE_MERGING
+    control_mode_t control;         //!< Path control mode, moves are only merged in G64 mode.
 #endif
     spindle_t spindle;              // Desired spindle parameters, such as RPM, through line motion.
     planner_cond_t condition;       // Bitfield variable to indicate planner conditions. See defines above.
     gc_override_flags_t overrides;  // Block bitfield variable for overrides
     offset_id_t offset_id;
     int32_t line_number;            // Desired line number to report when executing.
+#if ENABLE_NATIVE_ARCS
+    plan_arc_t *arc;                // Arc geometry, only used when condition.arc_motion is set.
+#endif
+#if ENABLE_ADAPTIVE_SPLINES
+    float max_rate;                 // Maximum rate of the motion, not subject to overrides. Set to 0 for no limit.
+#endif
 //    void *parameters;               // TODO: pointer to extra parameters, for canned cycles and threading?
     char *message;                  // Message to be displayed when block is executed.
     output_command_t *output_commands;
@@ -145,6 +177,10 @@ typedef struct {
                                     // i.e. arcs, canned cycles, and backlash compensation.
   float previous_unit_vec[N_AXIS];  // Unit vector of previous path line segment
   float previous_nominal_speed;     // Nominal speed of previous path line segment
+#if ENABLE_LINE_MERGING
+  float merge_unit_vec[N_AXIS];     // Unit vector of path line segment preceding the previous
+  float merge_deviation;            // Accumulated path deviation of moves merged into the previous path line segment
+#endif
 } planner_t;
 
 // Initialize and reset the motion plan subsystem
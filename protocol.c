@@ -115,6 +115,68 @@ static bool recheck_line (char *line, line_flags_t *flags)
     return keep_rt_commands;
 }
 
+// Adds a character to the line buffer, performs an initial filtering by removing leading spaces
+// and control characters and tracks comments for real-time command processing.
+static void line_add_char (int16_t c, line_flags_t *flags)
+{
+    if(c != ASCII_BS && c <= (char_counter > 0 ? ' ' - 1 : ' '))
+        return; // Strip control characters and leading whitespace.
+
+    switch(c) {
+
+        case '$':
+        case '[':
+            if(char_counter == 0)
+                keep_rt_commands = true;
+            break;
+
+        case '(':
+            if(!keep_rt_commands && (flags->comment_parentheses = !flags->comment_semicolon))
+                keep_rt_commands = !hal.driver_cap.no_gcode_message_handling; // Suspend real-time processing of printable command characters.
+            break;
+
+        case ')':
+            if(!flags->comment_semicolon)
+                flags->comment_parentheses = keep_rt_commands = false;
+            break;
+
+        case ';':
+            if(!flags->comment_parentheses) {
+                keep_rt_commands = false;
+                flags->comment_semicolon = On;
+            }
+            break;
+
+        case ASCII_BS:
+        case ASCII_DEL:
+            if(char_counter) {
+                line[--char_counter] = '\0';
+                keep_rt_commands = recheck_line(line, flags);
+            }
+            return;
+    }
+
+    if(!(flags->overflow = char_counter >= (LINE_BUFFER_SIZE - 1)))
+        line[char_counter++] = c;
+}
+
+// Fetches input from the stream, if the stream can hand over a complete line it is
+// processed in a single pass and a linefeed is returned to trigger execution.
+// Otherwise the next character from the stream is returned.
+static int16_t stream_read_line (line_flags_t *flags)
+{
+    char *s;
+    size_t length;
+
+    if(char_counter == 0 && hal.stream.read_line && hal.stream.read_line(&s, &length)) {
+        while(length--)
+            line_add_char((uint8_t)*s++, flags);
+        return ASCII_LF;
+    }
+
+    return hal.stream.read();
+}
+
 /*
   grblHAL PRIMARY LOOP:
 */
@@ -202,7 +264,7 @@ bool protocol_main_loop (void)
 
         // Process one line of incoming stream data, as the data becomes available. Performs an
         // initial filtering by removing leading spaces and control characters.
-        while((c = hal.stream.read()) != SERIAL_NO_DATA) {
+        while((c = stream_read_line(&line_flags)) != SERIAL_NO_DATA) {
 
             if(c == ASCII_CAN) {
 
@@ -284,45 +346,8 @@ bool protocol_main_loop (void)
                 keep_rt_commands = false;
                 char_counter = line_flags.value = 0;
 
-            } else if (c != ASCII_BS && c <= (char_counter > 0 ? ' ' - 1 : ' '))
-                continue; // Strip control characters and leading whitespace.
-            else {
-                switch(c) {
-
-                    case '$':
-                    case '[':
-                        if(char_counter == 0)
-                            keep_rt_commands = true;
-                        break;
-
-                    case '(':
-                        if(!keep_rt_commands && (line_flags.comment_parentheses = !line_flags.comment_semicolon))
-                            keep_rt_commands = !hal.driver_cap.no_gcode_message_handling; // Suspend real-time processing of printable command characters.
-                        break;
-
-                    case ')':
-                        if(!line_flags.comment_semicolon)
-                            line_flags.comment_parentheses = keep_rt_commands = false;
-                        break;
-
-                    case ';':
-                        if(!line_flags.comment_parentheses) {
-                            keep_rt_commands = false;
-                            line_flags.comment_semicolon = On;
-                        }
-                        break;
-
-                    case ASCII_BS:
-                    case ASCII_DEL:
-                        if(char_counter) {
-                            line[--char_counter] = '\0';
-                            keep_rt_commands = recheck_line(line, &line_flags);
-                        }
-                        continue;
-                }
-                if(!(line_flags.overflow = char_counter >= (LINE_BUFFER_SIZE - 1)))
-                    line[char_counter++] = c;
-            }
+            } else
+                line_add_char(c, &line_flags);
         }
 
         // Handle extra command (internal stream)
@@ -951,6 +976,11 @@ ISR_CODE bool ISR_FUNC(protocol_enqueue_realtime_command)(char c)
                 sys.flags.auto_reporting = !sys.flags.auto_reporting;
             break;
 
+        case CMD_STATUS_REPORT_BINARY_TOGGLE:
+            if((drop = hal.stream.write_n != NULL))
+                task_add_immediate(report_realtime_binary_toggle, NULL);
+            break;
+
         case CMD_OVERRIDE_FEED_RESET:
         case CMD_OVERRIDE_FEED_COARSE_PLUS:
         case CMD_OVERRIDE_FEED_COARSE_MINUS:
@@ -40,11 +40,37 @@
 #include "state_machine.h"
 #include "canbus.h"
 #include "regex.h"
+#include "crc.h"
 
 #if ENABLE_SPINDLE_LINEARIZATION
 #include <stdio.h>
 #endif
 
+#ifndef REPORT_RT_BUFFER_SIZE
+#define REPORT_RT_BUFFER_SIZE 256
+#endif
+
+#ifndef REPORT_DELTA_MAX_CONNECTIONS
+#define REPORT_DELTA_MAX_CONNECTIONS 4
+#endif
+
+#define REPORT_DELTA_MAX_FIELDS (6 + N_SYS_SPINDLE)
+
+typedef struct {
+    char key[6];
+    uint16_t offset;        // Offset of the field in the report text.
+    uint16_t length;
+} rt_report_field_t;
+
+typedef struct {
+    const io_stream_t *stream;
+    bool seen;
+    uint8_t reports;        // Number of delta reports sent since last full report.
+    uint_fast8_t n_fields;
+    rt_report_field_t field[REPORT_DELTA_MAX_FIELDS];
+    char text[REPORT_RT_BUFFER_SIZE]; // Last report assembled, the fields are compared to it.
+} rt_report_snapshot_t;
+
 static char buf[(STRLEN_COORDVALUE + 1) * N_AXIS];
 static char *(*get_axis_values)(float *axis_values);
 static char *(*get_axis_value)(float value);
@@ -52,6 +78,20 @@ static char *(*get_rate_value)(float value);
 static uint8_t override_counter = 0; // Tracks when to add override data to status reports.
 static uint8_t wco_counter = 0;      // Tracks when to add work coordinate offset data to status reports.
 static const char vbar[2] = { '|', '\0' };
+static struct {
+    uint_fast16_t length;
+    bool overflow;
+    uint_fast8_t n_fields;
+    uint16_t field[REPORT_DELTA_MAX_FIELDS]; // Offsets of fields that may be omitted in delta reports.
+    char data[REPORT_RT_BUFFER_SIZE];
+} rt_report;  // Realtime report is assembled here before output.
+static rt_report_snapshot_t *rt_snapshots = NULL; // Per connection last sent field values for delta reports.
+static char *rt_delta = NULL;                       // Delta report is assembled here, allocated with the snapshots.
+static struct {
+    uint_fast8_t n;
+    bool seen[REPORT_DELTA_MAX_CONNECTIONS];
+    const io_stream_t *stream[REPORT_DELTA_MAX_CONNECTIONS];
+} rt_binary = {0}; // Connections receiving realtime reports as binary frames.
 
 // Append a number of strings to the static buffer
 // NOTE: do NOT use for several int/float conversions as these share the same underlying buffer!
@@ -1117,6 +1157,207 @@ void report_echo_line_received (char *line)
     hal.stream.write("]" ASCII_EOL);
 }
 
+static int_fast8_t rt_binary_get (const io_stream_t *stream)
+{
+    int_fast8_t idx = rt_binary.n ? REPORT_DELTA_MAX_CONNECTIONS : 0;
+
+    while(idx) {
+        if(rt_binary.stream[--idx] == stream)
+            return idx;
+    }
+
+    return -1;
+}
+
+static bool rt_report_write_text (const io_stream_t *stream, void *data)
+{
+    if(rt_binary_get(stream) < 0)
+        stream->write(rt_report.data);
+
+    return false;
+}
+
+// Flush the realtime report buffer, the report is written to all connected streams in one go.
+// Connections receiving binary frames are skipped.
+static void rt_report_flush (void)
+{
+    if(rt_report.length) {
+        rt_report.data[rt_report.length] = '\0';
+        if(rt_binary.n)
+            stream_enumerate_connections(rt_report_write_text, NULL);
+        else
+            hal.stream.write_all(rt_report.data);
+        rt_report.length = 0;
+        rt_report.overflow = true;
+    }
+}
+
+// Mark start of a field that may be omitted in delta reports if unchanged.
+static inline void rt_report_field (void)
+{
+    if(rt_report.n_fields < REPORT_DELTA_MAX_FIELDS)
+        rt_report.field[rt_report.n_fields++] = rt_report.length;
+}
+
+static uint_fast16_t rt_report_field_length (uint_fast16_t offset)
+{
+    uint_fast16_t length = 1;
+
+    while(offset + length < rt_report.length && rt_report.data[offset + length] != '|' && rt_report.data[offset + length] != '>')
+        length++;
+
+    return length;
+}
+
+static rt_report_field_t *rt_snapshot_get (rt_report_snapshot_t *snapshot, const char *key)
+{
+    uint_fast8_t idx = snapshot->n_fields;
+
+    while(idx) {
+        if(!strcmp(snapshot->field[--idx].key, key))
+            return &snapshot->field[idx];
+    }
+
+    return NULL;
+}
+
+// Writes the report to a connection, fields unchanged since last written are omitted.
+static bool rt_report_write_delta (const io_stream_t *stream, void *data)
+{
+    bool keyframe = *(bool *)data;
+    char key[sizeof(((rt_report_field_t *)0)->key)], *d = rt_delta;
+    uint_fast8_t idx, field = 0, n_fields = 0;
+    uint_fast16_t offset = 0, length;
+    rt_report_field_t fields[REPORT_DELTA_MAX_FIELDS], *prev;
+    rt_report_snapshot_t *snapshot = NULL;
+
+    if(rt_binary_get(stream) >= 0)
+        return false;
+
+    for(idx = 0; idx < REPORT_DELTA_MAX_CONNECTIONS; idx++) {
+        if(rt_snapshots[idx].stream == stream) {
+            snapshot = &rt_snapshots[idx];
+            break;
+        } else if(snapshot == NULL && rt_snapshots[idx].stream == NULL)
+            snapshot = &rt_snapshots[idx];
+    }
+
+    if(snapshot == NULL) {
+        stream->write(rt_report.data);
+        return false;
+    }
+
+    if(snapshot->stream != stream) {
+        snapshot->stream = stream;
+        keyframe = true;
+    } else if(++snapshot->reports >= REPORT_DELTA_KEYFRAME_INTERVAL)
+        keyframe = true;
+
+    if(keyframe) {
+        snapshot->reports = 0;
+        snapshot->n_fields = 0;
+    }
+
+    snapshot->seen = true;
+
+    while(offset < rt_report.length) {
+
+        if(field < rt_report.n_fields && offset == rt_report.field[field]) {
+
+            length = rt_report_field_length(offset);
+
+            for(idx = 0; idx < sizeof(key) - 1 && rt_report.data[offset + idx + 1] != ':' && idx + 1 < length; idx++)
+                key[idx] = rt_report.data[offset + idx + 1];
+            key[idx] = '\0';
+
+            strcpy(fields[n_fields].key, key);
+            fields[n_fields].offset = offset;
+            fields[n_fields].length = length;
+
+            if(keyframe || (prev = rt_snapshot_get(snapshot, key)) == NULL || prev->length != length ||
+                memcmp(&snapshot->text[prev->offset], &rt_report.data[offset], length)) {
+                memcpy(d, &rt_report.data[offset], length);
+                d += length;
+            }
+
+            n_fields++;
+            field++;
+        } else {
+            length = field < rt_report.n_fields ? rt_report.field[field] - offset : rt_report.length - offset;
+            if(offset && offset + length == rt_report.length && n_fields == rt_report.n_fields) {
+                // Send fields no longer present with an empty value before the trailing part of the report.
+                for(idx = 0; idx < snapshot->n_fields; idx++) {
+                    uint_fast8_t i = n_fields;
+                    while(i && strcmp(fields[i - 1].key, snapshot->field[idx].key))
+                        i--;
+                    if(i == 0 && (d - rt_delta) + strlen(snapshot->field[idx].key) + 2 < REPORT_RT_BUFFER_SIZE - length) {
+                        *d++ = '|';
+                        d = strchr(strcpy(d, snapshot->field[idx].key), '\0');
+                        *d++ = ':';
+                    }
+                }
+            }
+            memcpy(d, &rt_report.data[offset], length);
+            d += length;
+        }
+
+        offset += length;
+    }
+
+    *d = '\0';
+
+    memcpy(snapshot->field, fields, n_fields * sizeof(rt_report_field_t));
+    memcpy(snapshot->text, rt_report.data, rt_report.length);
+    snapshot->n_fields = n_fields;
+
+    stream->write(rt_delta);
+
+    return false;
+}
+
+static void rt_report_flush_delta (bool keyframe)
+{
+    uint_fast8_t idx;
+
+    // The delta report buffer is allocated after the snapshots.
+    if(rt_snapshots == NULL) {
+        if((rt_snapshots = calloc(1, REPORT_DELTA_MAX_CONNECTIONS * sizeof(rt_report_snapshot_t) + REPORT_RT_BUFFER_SIZE)) == NULL) {
+            rt_report_flush();
+            return;
+        }
+        rt_delta = (char *)&rt_snapshots[REPORT_DELTA_MAX_CONNECTIONS];
+    }
+
+    for(idx = 0; idx < REPORT_DELTA_MAX_CONNECTIONS; idx++)
+        rt_snapshots[idx].seen = false;
+
+    if(rt_report.overflow)
+        rt_report_flush();
+    else {
+        rt_report.data[rt_report.length] = '\0';
+        stream_enumerate_connections(rt_report_write_delta, &keyframe);
+        rt_report.length = 0;
+    }
+
+    // Forget connections not seen so that they get a full report when up again.
+    for(idx = 0; idx < REPORT_DELTA_MAX_CONNECTIONS; idx++) {
+        if(!rt_snapshots[idx].seen || rt_report.overflow)
+            rt_snapshots[idx].stream = NULL;
+    }
+}
+
+// Append string to the realtime report buffer, flushes the buffer if full.
+static void rt_report_append (const char *s)
+{
+    char c;
+
+    while((c = *s++)) {
+        if(rt_report.length == REPORT_RT_BUFFER_SIZE - 1)
+            rt_report_flush();
+        rt_report.data[rt_report.length++] = c;
+    }
+}
+
 #if N_SYS_SPINDLE == 1 && N_SPINDLE > 1
 
 static bool report_spindle_num (spindle_info_t *spindle, void *data)
@@ -1124,13 +1365,150 @@ static bool report_spindle_num (spindle_info_t *spindle, void *data)
     bool ok;
 
     if((ok = spindle->id == *((spindle_id_t *)data)))
-        hal.stream.write_all(appendbuf(2, "|S:", uitoa((uint32_t)spindle->num)));
+        rt_report_append(appendbuf(2, "|S:", uitoa((uint32_t)spindle->num)));
 
     return ok;
 }
 
 #endif
 
+typedef struct {
+    status_frame_t frame;
+    bool text;          // Set when a connection is to receive the text report.
+} rt_binary_output_t;
+
+static bool rt_report_write_binary (const io_stream_t *stream, void *data)
+{
+    int_fast8_t idx;
+
+    if((idx = rt_binary_get(stream)) >= 0) {
+        rt_binary.seen[idx] = true;
+        stream->write_n((char *)&((rt_binary_output_t *)data)->frame, sizeof(status_frame_t));
+    } else
+        ((rt_binary_output_t *)data)->text = true;
+
+    return false;
+}
+
+// Toggles binary realtime reports for the connection the current stream writes to,
+// called via the task queue when the CMD_STATUS_REPORT_BINARY_TOGGLE realtime command is received.
+static bool rt_binary_toggle (const io_stream_t *stream, void *data)
+{
+    int_fast8_t idx;
+
+    if(stream->write != hal.stream.write || stream->write_n == NULL)
+        return false;
+
+    if((idx = rt_binary_get(stream)) >= 0) {
+        rt_binary.stream[idx] = NULL;
+        rt_binary.n--;
+    } else for(idx = 0; idx < REPORT_DELTA_MAX_CONNECTIONS; idx++) {
+        if(rt_binary.stream[idx] == NULL) {
+            rt_binary.stream[idx] = stream;
+            rt_binary.n++;
+            break;
+        }
+    }
+
+    if(rt_snapshots) for(idx = 0; idx < REPORT_DELTA_MAX_CONNECTIONS; idx++) {
+        if(rt_snapshots[idx].stream == stream)
+            rt_snapshots[idx].stream = NULL; // Send a full text report when switched back.
+    }
+
+    return true;
+}
+
+void report_realtime_binary_toggle (void *data)
+{
+    stream_enumerate_connections(rt_binary_toggle, NULL);
+}
+
+// Outputs real-time data as a binary frame to the connections that have requested it, see status_frame_t for layout.
+// The frame is written with write_n as it cannot be sent as a null terminated string.
+// Returns true if there are connections left that are to receive the text report.
+static bool report_realtime_status_binary (void)
+{
+    uint_fast8_t idx;
+    rt_binary_output_t output;
+    status_frame_t *frame = &output.frame;
+    spindle_ptrs_t *spindle_0 = spindle_get(0);
+    spindle_state_t spindle_0_state = spindle_0->get_state(spindle_0);
+    control_signals_t ctrl_pin_state = hal.control.get_state();
+    probe_state_t probe_state = {
+        .connected = On,
+        .triggered = Off
+    };
+    sys_state_t state = state_get();
+
+    if(hal.probe.get_state)
+        probe_state = hal.probe.get_state();
+
+    ctrl_pin_state.probe_triggered = probe_state.triggered;
+    ctrl_pin_state.probe_disconnected = !probe_state.connected;
+
+    if(gc_state.tool_change && state == STATE_CYCLE)
+        state = STATE_TOOL_CHANGE;
+
+    frame->sof = STATUS_FRAME_SOF;
+    frame->length = sizeof(status_frame_t);
+    frame->version = STATUS_FRAME_VERSION;
+    frame->n_axis = N_AXIS;
+    frame->state = (uint16_t)state;
+
+    switch(state) {
+
+        case STATE_CYCLE:
+            frame->substate = sys.flags.feed_hold_pending;
+            break;
+
+        case STATE_HOLD:
+            frame->substate = (uint8_t)(sys.holding_state - 1);
+            break;
+
+        case STATE_SAFETY_DOOR:
+            frame->substate = (uint8_t)sys.parking_state;
+            break;
+
+        case STATE_ESTOP:
+        case STATE_ALARM:
+            frame->substate = (uint8_t)sys.alarm;
+            break;
+
+        default:
+            frame->substate = 0;
+            break;
+    }
+
+    frame->wcs = (uint8_t)gc_state.modal.coord_system.id;
+    memcpy(frame->position, sys.position, sizeof(frame->position));
+    frame->feed_rate = st_get_realtime_rate();
+    frame->rpm = spindle_0_state.on ? spindle_0->param->rpm_overridden : 0.0f;
+    frame->override_feed = (uint8_t)sys.override.feed_rate;
+    frame->override_rapid = (uint8_t)sys.override.rapid_rate;
+    frame->override_spindle = (uint8_t)spindle_0->param->override_pct;
+    frame->spindle = spindle_0_state.value;
+    frame->coolant = hal.coolant.get_state().value;
+    frame->limits = limit_signals_merge(hal.limits.get_state()).value;
+    frame->control = ctrl_pin_state.value;
+    frame->crc = modbus_crc16x((uint8_t *)frame, offsetof(status_frame_t, crc));
+
+    for(idx = 0; idx < REPORT_DELTA_MAX_CONNECTIONS; idx++)
+        rt_binary.seen[idx] = false;
+
+    output.text = false;
+    stream_enumerate_connections(rt_report_write_binary, &output);
+
+    // Forget connections not seen so that they get text reports when up again.
+    for(idx = 0; idx < REPORT_DELTA_MAX_CONNECTIONS; idx++) {
+        if(rt_binary.stream[idx] && !rt_binary.seen[idx]) {
+            rt_binary.stream[idx] = NULL;
+            rt_binary.n--;
+        }
+    }
+
+    return output.text;
+}
+
  // Prints real-time data. This function grabs a real-time snapshot of the stepper subprogram
  // and the actual location of the CNC machine. Users may change the following function to their
  // specific needs, but the desired real-time data report must be as short as possible. This is
@@ -1140,6 +1518,9 @@ void report_realtime_status (void)
 {
     static bool probing = false;
 
+    if(rt_binary.n && !report_realtime_status_binary())
+        return;
+
     float print_position[N_AXIS];
     report_tracking_flags_t report = system_get_rt_report_flags();
     probe_state_t probe_state = {
@@ -1153,62 +1534,65 @@ void report_realtime_status (void)
         probe_state = hal.probe.get_state();
 
     // Report current machine state and sub-states
-    hal.stream.write_all("<");
+    rt_report.length = 0;
+    rt_report.n_fields = 0;
+    rt_report.overflow = false;
+    rt_report_append("<");
 
     sys_state_t state = state_get();
 
     switch (gc_state.tool_change && state == STATE_CYCLE ? STATE_TOOL_CHANGE : state) {
 
         case STATE_IDLE:
-            hal.stream.write_all("Idle");
+            rt_report_append("Idle");
             break;
 
         case STATE_CYCLE:
-            hal.stream.write_all("Run");
+            rt_report_append("Run");
             if(sys.probing_state == Probing_Active && settings.status_report.run_substate)
                 probing = true;
             else if (probing)
                 probing = probe_state.triggered;
             if(sys.flags.feed_hold_pending)
-                hal.stream.write_all(":1");
+                rt_report_append(":1");
             else if(probing)
-                hal.stream.write_all(":2");
+                rt_report_append(":2");
             break;
 
         case STATE_HOLD:
-            hal.stream.write_all(appendbuf(2, "Hold:", uitoa((uint32_t)(sys.holding_state - 1))));
+            rt_report_append(appendbuf(2, "Hold:", uitoa((uint32_t)(sys.holding_state - 1))));
             break;
 
         case STATE_JOG:
-            hal.stream.write_all("Jog");
+            rt_report_append("Jog");
             break;
 
         case STATE_HOMING:
-            hal.stream.write_all("Home");
+            rt_report_append("Home");
             break;
 
         case STATE_ESTOP:
         case STATE_ALARM:
             if((report.all || settings.status_report.alarm_substate) && sys.alarm)
-                hal.stream.write_all(appendbuf(2, "Alarm:", uitoa((uint32_t)sys.alarm)));
+                rt_report_append(appendbuf(2, "Alarm:", uitoa((uint32_t)sys.alarm)));
             else
-                hal.stream.write_all("Alarm");
+                rt_report_append("Alarm");
             break;
 
         case STATE_CHECK_MODE:
-            hal.stream.write_all("Check");
+            rt_report_append("Check");
             break;
 
         case STATE_SAFETY_DOOR:
-            hal.stream.write_all(appendbuf(2, "Door:", uitoa((uint32_t)sys.parking_state)));
+            rt_report_append(appendbuf(2, "Door:", uitoa((uint32_t)sys.parking_state)));
             break;
 
         case STATE_SLEEP:
-            hal.stream.write_all("Sleep");
+            rt_report_append("Sleep");
             break;
 
         case STATE_TOOL_CHANGE:
-            hal.stream.write_all("Tool");
+            rt_report_append("Tool");
             break;
     }
 
@@ -1224,23 +1608,27 @@ void report_realtime_status (void)
     }
 
     // Report position
-    hal.stream.write_all(settings.status_report.machine_position ? "|MPos:" : "|WPos:");
-    hal.stream.write_all(get_axis_values(print_position));
+    rt_report_field();
+    rt_report_append(settings.status_report.machine_position ? "|MPos:" : "|WPos:");
+    rt_report_append(get_axis_values(print_position));
 
     // Returns planner and output stream buffer states.
 
     if (settings.status_report.buffer_state) {
-        hal.stream.write_all("|Bf:");
-        hal.stream.write_all(uitoa((uint32_t)plan_get_block_buffer_available()));
-        hal.stream.write_all(",");
-        hal.stream.write_all(uitoa(hal.stream.get_rx_buffer_free()));
+        rt_report_field();
+        rt_report_append("|Bf:");
+        rt_report_append(uitoa((uint32_t)plan_get_block_buffer_available()));
+        rt_report_append(",");
+        rt_report_append(uitoa(hal.stream.get_rx_buffer_free()));
     }
 
     if(settings.status_report.line_numbers) {
         // Report current line number
         plan_block_t *cur_block = plan_get_current_block();
-        if (cur_block != NULL && cur_block->line_number > 0)
-            hal.stream.write_all(appendbuf(2, "|Ln:", uitoa((uint32_t)cur_block->line_number)));
+        if (cur_block != NULL && cur_block->line_number > 0) {
+            rt_report_field();
+            rt_report_append(appendbuf(2, "|Ln:", uitoa((uint32_t)cur_block->line_number)));
+        }
     }
 
     spindle_ptrs_t *spindle_0;
@@ -1251,13 +1639,14 @@ void report_realtime_status (void)
 
     // Report realtime feed speed
     if(settings.status_report.feed_speed) {
+        rt_report_field();
         if(spindle_0->cap.variable) {
-            hal.stream.write_all(appendbuf(2, "|FS:", get_rate_value(st_get_realtime_rate())));
-            hal.stream.write_all(appendbuf(2, ",", uitoa(spindle_0_state.on ? lroundf(spindle_0->param->rpm_overridden) : 0)));
+            rt_report_append(appendbuf(2, "|FS:", get_rate_value(st_get_realtime_rate())));
+            rt_report_append(appendbuf(2, ",", uitoa(spindle_0_state.on ? lroundf(spindle_0->param->rpm_overridden) : 0)));
             if(spindle_0->get_data /* && sys.mpg_mode */)
-                hal.stream.write_all(appendbuf(2, ",", uitoa(lroundf(spindle_0->get_data(SpindleData_RPM)->rpm))));
+                rt_report_append(appendbuf(2, ",", uitoa(lroundf(spindle_0->get_data(SpindleData_RPM)->rpm))));
         } else
-            hal.stream.write_all(appendbuf(2, "|F:", get_rate_value(st_get_realtime_rate())));
+            rt_report_append(appendbuf(2, "|F:", get_rate_value(st_get_realtime_rate())));
     }
 
 #if N_SYS_SPINDLE > 1
@@ -1269,10 +1658,11 @@ void report_realtime_status (void)
 
         if((spindle_n = spindle_get(idx))) {
             spindle_n_state = spindle_n->get_state(spindle_n);
-            hal.stream.write_all(appendbuf(3, "|SP", uitoa(idx), ":"));
-            hal.stream.write_all(appendbuf(3, uitoa(spindle_n_state.on ? lroundf(spindle_n->param->rpm_overridden) : 0), ",,", spindle_n_state.on ? (spindle_n_state.ccw ? "C" : "S") : ""));
+            rt_report_field();
+            rt_report_append(appendbuf(3, "|SP", uitoa(idx), ":"));
+            rt_report_append(appendbuf(3, uitoa(spindle_n_state.on ? lroundf(spindle_n->param->rpm_overridden) : 0), ",,", spindle_n_state.on ? (spindle_n_state.ccw ? "C" : "S") : ""));
             if(settings.status_report.overrides)
-                hal.stream.write_all(appendbuf(2, ",", uitoa(spindle_n->param->override_pct)));
+                rt_report_append(appendbuf(2, ",", uitoa(spindle_n->param->override_pct)));
         }
     }
 
@@ -1317,7 +1707,8 @@ void report_realtime_status (void)
                 append = control_signals_tostring(append, ctrl_pin_state);
 
             *append = '\0';
-            hal.stream.write_all(buf);
+            rt_report_field();
+            rt_report_append(buf);
         }
     }
 
@@ -1357,21 +1748,21 @@ void report_realtime_status (void)
             // delay outputting WCO until sync is completed
             // unless requested from stepper_driver_interrupt_handler.
             if(report.force_wco || !sys.flags.synchronizing) {
-                hal.stream.write_all("|WCO:");
-                hal.stream.write_all(get_axis_values(wco));
+                rt_report_append("|WCO:");
+                rt_report_append(get_axis_values(wco));
             } else
                 wco_counter = 0;
         }
 
         if(report.gwco) {
-            hal.stream.write_all("|WCS:");
-            hal.stream.write_all(gc_coord_system_to_str(gc_state.modal.coord_system.id));
+            rt_report_append("|WCS:");
+            rt_report_append(gc_coord_system_to_str(gc_state.modal.coord_system.id));
         }
 
         if(report.overrides) {
-            hal.stream.write_all(appendbuf(2, "|Ov:", uitoa((uint32_t)sys.override.feed_rate)));
-            hal.stream.write_all(appendbuf(2, ",", uitoa((uint32_t)sys.override.rapid_rate)));
-            hal.stream.write_all(appendbuf(2, ",", uitoa((uint32_t)spindle_0->param->override_pct)));
+            rt_report_append(appendbuf(2, "|Ov:", uitoa((uint32_t)sys.override.feed_rate)));
+            rt_report_append(appendbuf(2, ",", uitoa((uint32_t)sys.override.rapid_rate)));
+            rt_report_append(appendbuf(2, ",", uitoa((uint32_t)spindle_0->param->override_pct)));
         }
 
         if(report.spindle || report.coolant || report.tool || gc_state.tool_change) {
@@ -1401,58 +1792,58 @@ void report_realtime_status (void)
                 *append++ = 'T';
 
             *append = '\0';
-            hal.stream.write_all(buf);
+            rt_report_append(buf);
         }
 
         if(report.scaling) {
             axis_signals_tostring(buf, gc_get_g51_state());
-            hal.stream.write_all("|Sc:");
-            hal.stream.write_all(buf);
+            rt_report_append("|Sc:");
+            rt_report_append(buf);
         }
 
 #if COMPATIBILITY_LEVEL <= 1
         if((report.all || report.mpg_mode) && settings.report_interval) {
-            hal.stream.write_all(sys.flags.auto_reporting ? "|AR:" : "|AR");
+            rt_report_append(sys.flags.auto_reporting ? "|AR:" : "|AR");
             if(sys.flags.auto_reporting)
-                hal.stream.write_all(uitoa(settings.report_interval));
+                rt_report_append(uitoa(settings.report_interval));
         }
 #endif
 
         if(report.mpg_mode)
-            hal.stream.write_all(sys.mpg_mode ? "|MPG:1" : "|MPG:0");
+            rt_report_append(sys.mpg_mode ? "|MPG:1" : "|MPG:0");
 
         if(report.homed && (sys.homing.mask || settings.homing.flags.single_axis_commands || settings.homing.flags.manual)) {
             axes_signals_t homing = {sys.homing.mask ? sys.homing.mask : AXES_BITMASK};
-            hal.stream.write_all(appendbuf(2, "|H:", (homing.mask & sys.homed.mask) == homing.mask ? "1" : "0"));
+            rt_report_append(appendbuf(2, "|H:", (homing.mask & sys.homed.mask) == homing.mask ? "1" : "0"));
             if(settings.homing.flags.single_axis_commands)
-                hal.stream.write_all(appendbuf(2, ",", uitoa(sys.homed.mask)));
+                rt_report_append(appendbuf(2, ",", uitoa(sys.homed.mask)));
         }
 
         if(report.xmode && settings.mode == Mode_Lathe)
-            hal.stream.write_all(gc_state.modal.diameter_mode ? "|D:1" : "|D:0");
+            rt_report_append(gc_state.modal.diameter_mode ? "|D:1" : "|D:0");
 
         if(report.tool)
-            hal.stream.write_all(appendbuf(2, "|T:", uitoa((uint32_t)gc_state.tool->tool_id)));
+            rt_report_append(appendbuf(2, "|T:", uitoa((uint32_t)gc_state.tool->tool_id)));
 
         if(report.tlo_reference)
-            hal.stream.write_all(appendbuf(2, "|TLR:", uitoa(sys.tlo_reference_set.mask != 0)));
+            rt_report_append(appendbuf(2, "|TLR:", uitoa(sys.tlo_reference_set.mask != 0)));
 
         if(report.m66result && sys.var5399 > -2) { // M66 result
             if(sys.var5399 >= 0)
-                hal.stream.write_all(appendbuf(2, "|In:", uitoa(sys.var5399)));
+                rt_report_append(appendbuf(2, "|In:", uitoa(sys.var5399)));
             else
-                hal.stream.write_all("|In:-1");
+                rt_report_append("|In:-1");
         }
     }
 
     if(grbl.on_realtime_report)
-        grbl.on_realtime_report(hal.stream.write_all, sys.report);
+        grbl.on_realtime_report(rt_report_append, sys.report);
 
 #if COMPATIBILITY_LEVEL <= 1
     if(report.all) {
-        hal.stream.write_all("|FW:grblHAL");
+        rt_report_append("|FW:grblHAL");
         if(sys.blocking_event)
-            hal.stream.write_all("|$C:1");
+            rt_report_append("|$C:1");
     } else
 #endif
 
@@ -1484,7 +1875,12 @@ void report_realtime_status (void)
             system_set_exec_state_flag(EXEC_TLO_REPORT);
     }
 
-    hal.stream.write_all(">" ASCII_EOL);
+    rt_report_append(">" ASCII_EOL);
+
+    if(settings.status_report.delta)
+        rt_report_flush_delta(report.all);
+    else
+        rt_report_flush();
 
     system_add_rt_report(Report_ClearAll);
     if(settings.status_report.work_coord_offset && wco_counter == 0)
@@ -2683,6 +3079,8 @@ void report_init_fns (void)
 {
     memcpy(&grbl.report, &report_fns, sizeof(report_t));
 
+    memset(&rt_binary, 0, sizeof(rt_binary)); // Revert to text realtime reports.
+
     if(grbl.on_report_handlers_init)
         grbl.on_report_handlers_init();
 }
@@ -26,6 +26,36 @@
 #include "system.h"
 #include "ngc_params.h"
 
+#define STATUS_FRAME_SOF        0x02 //!< Binary status frame start of frame marker (STX).
+#define STATUS_FRAME_VERSION    1
+
+/*! \brief Binary realtime status frame.
+
+Output instead of the text report to connections that have enabled it with the #CMD_STATUS_REPORT_BINARY_TOGGLE realtime command,
+other connections still receive the text report. The mode is kept per connection and is cleared on soft reset.
+Multibyte values are little endian, the CRC is CRC-16/MODBUS calculated over all preceding bytes.
+*/
+typedef struct {
+    uint8_t sof;                //!< Start of frame, #STATUS_FRAME_SOF.
+    uint8_t length;             //!< Frame length in bytes, including start of frame and CRC.
+    uint8_t version;            //!< Frame layout version, #STATUS_FRAME_VERSION.
+    uint8_t n_axis;             //!< Number of entries in the position array.
+    uint16_t state;             //!< Machine state, STATE_* bitmap.
+    uint8_t substate;           //!< Hold, door or alarm substate. For the run state 1 if a feed hold is pending.
+    uint8_t wcs;                //!< Active work coordinate system, see #coord_system_id_t.
+    int32_t position[N_AXIS];   //!< Machine position in steps.
+    float feed_rate;            //!< Current feed rate in mm/min.
+    float rpm;                  //!< Programmed spindle RPM with override applied, 0 if spindle is off.
+    uint8_t override_feed;      //!< Feed override in percent.
+    uint8_t override_rapid;     //!< Rapids override in percent.
+    uint8_t override_spindle;   //!< Spindle override in percent.
+    uint8_t spindle;            //!< Spindle state, see #spindle_state_t.
+    uint8_t coolant;            //!< Coolant state, see #coolant_state_t.
+    uint8_t limits;             //!< Limit switches state, see #axes_signals_t.
+    uint16_t control;           //!< Control signals state, see #control_signals_t.
+    uint16_t crc;               //!< CRC-16/MODBUS of the preceding bytes.
+} __attribute__ ((__packed__)) status_frame_t;
+
 typedef enum {
     SettingsFormat_MachineReadable = 0,
     SettingsFormat_HumanReadable,
@@ -66,6 +96,9 @@ void report_echo_line_received (char *line);
 // Prints realtime status report.
 void report_realtime_status (void);
 
+// Toggles binary realtime status reports for the connection the current stream writes to.
+void report_realtime_binary_toggle (void *data);
+
 // Prints recorded probe position.
 void report_probe_parameters (void);
 
@@ -630,7 +630,8 @@ typedef union {
                  alarm_substate     :1,
                  run_substate       :1,
                  when_homing        :1,
-                 unassigned         :3;
+                 delta              :1,
+                 unassigned         :2;
     };
 } reportmask_t;
 
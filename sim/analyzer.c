@@ -0,0 +1,555 @@
+/*
+
+  analyzer.c - step pulse timeline analyzer for the grblHAL host simulator
+
+  Part of grblHAL
+
+  grblHAL is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  grblHAL is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with grblHAL. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  Usage: step_analyzer [-v] [-w <ms>] [-t <s>] [-s <segments>] [-j <steps/s>,...] [-m <steps/s^2>,...] [-a <steps/s^2>,...] [-k <steps/s^3>,...] [-p <pos>,<pos>,...] [-c <event file>] [-r <us>] [-n <events>] <event file>
+
+  Reads the event stream recorded by grbl_sim and reports segment timing, AMASS level changes,
+  step rate jitter, the step rate change per axis at segment boundaries and the acceleration change
+  per axis between consecutive segments.
+
+  -t fails the analysis if the timeline is longer than the given time, in seconds.
+  -s fails the analysis if the timeline has more segments than the given number.
+  -j fails the analysis if the step rate of any axis changes more than the given amount at a segment boundary.
+  -m fails the analysis if the acceleration of any axis exceeds the given amount.
+  -a fails the analysis if the acceleration of any axis changes more than the given amount between windows.
+  -k fails the analysis if the jerk of any axis, the acceleration change between windows divided by the window time,
+     exceeds the given amount.
+  -w sets the minimum window time in ms, default 5. Longer windows reduce the step count quantization in the
+     acceleration and jerk, use 20 ms or more for jerk checks.
+  -p fails the analysis if the final axis positions (in steps) do not match.
+  The -j, -m, -a and -k limits may be given per axis as a comma separated list, the last value applies to
+  the remaining axes.
+  -r fails the analysis if a segment in an acceleration or deceleration ramp is longer than the given time, in us.
+     Segments are in a ramp when their step event period differs from those of both neighbouring segments.
+  -n fails the analysis if a segment has more step events than the given number, AMASS overdriven events included.
+  -c fails the analysis if the time, step and direction bits of the step records differ from those of another
+     event file, such as the timeline recorded by another simulator variant.
+  -v lists each segment and the step rate and acceleration per axis of each window.
+
+  Step rates are derived from the segment timer period: step_event_count / steps[axis] step events per axis step.
+  Accelerations are computed from the average step rates over consecutive windows of one or more segments.
+  The rate jitter is the deviation of the measured time between axis steps from that ideal, an inherent
+  property of Bresenham step distribution that is bounded by one step event period.
+  Step records without segment records, as output for batched step output, are only counted for the position.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#define MAX_AXES 8
+#define ACCEL_WINDOW 0.005 // Default minimum time (s) over which step rates are averaged for acceleration.
+
+typedef struct {
+    int64_t position;
+    uint64_t steps;
+    uint64_t last_pulse;    // Time of last step pulse, 0 if none since the stepper was idle.
+    double rate;            // Current step rate (steps/s).
+    double max_jump;        // Max rate change at a segment boundary (steps/s).
+    uint64_t max_jump_time;
+    double max_jitter;      // Max deviation from the ideal step interval (s).
+    double sum_jitter_sqr;
+    uint64_t jitter_count;
+    double max_rate;
+    double seg_rate;        // Average step rate of last window (steps/s).
+    double accel;           // Acceleration between the last two windows (steps/s^2).
+    double max_accel;
+    double max_accel_change;
+    uint64_t max_accel_change_time;
+    bool accel_valid;       // Set when accel is calculated from two windows.
+    double max_jerk;        // Max acceleration change divided by the time between windows (steps/s^3).
+    uint64_t max_jerk_time;
+} axis_t;
+
+typedef struct {
+    bool valid;
+    unsigned int n_step;
+    unsigned int level;
+    unsigned long cycles;
+    unsigned long step_event_count;
+    unsigned long steps[MAX_AXES];
+} segment_t;
+
+static bool verbose = false;
+static double accel_window = ACCEL_WINDOW;
+static axis_t axis[MAX_AXES];
+static struct {
+    uint64_t start;             // Start of current window, 0 if none.
+    uint64_t prev_start;        // Start of previous window, 0 if none.
+    double steps[MAX_AXES];     // Steps output in current window.
+} window;
+static struct {
+    uint64_t min;               // Min segment duration.
+    uint64_t max;               // Max segment duration.
+    uint64_t max_ramp;          // Max duration of segments in acceleration or deceleration.
+    uint64_t prev_period;       // Step event period of the previous segment, 0 if none.
+    unsigned int max_steps;     // Max step events of a segment.
+} durations = { .min = UINT64_MAX };
+static const char axis_letter[] = "XYZABCUV";
+
+static double axis_rate (segment_t *seg, uint_fast8_t idx, unsigned long cycles, double f)
+{
+    return seg->step_event_count && cycles ? f * (double)seg->steps[idx] / ((double)cycles * (double)seg->step_event_count) : 0.0;
+}
+
+// Returns the step event period of a segment in timer ticks, AMASS levels overdrive the timer.
+static uint64_t segment_period (segment_t *seg)
+{
+    return seg ? (uint64_t)seg->cycles << seg->level : 0;
+}
+
+// Updates the segment durations when a segment ends, next is NULL when the steppers go idle. A segment is in an
+// acceleration or deceleration ramp when its step event period differs from those of both the previous and the
+// next segment by more than the rounding to the timer tick of the segment.
+static void segment_duration (segment_t *seg, uint64_t duration, segment_t *next)
+{
+    uint64_t period = segment_period(seg), tick = (uint64_t)1 << seg->level;
+
+    if(duration < durations.min)
+        durations.min = duration;
+    if(duration > durations.max)
+        durations.max = duration;
+    if(seg->n_step > durations.max_steps)
+        durations.max_steps = seg->n_step;
+
+    if(llabs((long long)(period - durations.prev_period)) > (long long)tick &&
+        llabs((long long)(period - segment_period(next))) > (long long)tick && duration > durations.max_ramp)
+        durations.max_ramp = duration;
+
+    durations.prev_period = next ? period : 0;
+}
+
+// Updates the acceleration per axis at the end of a segment. Step rates are averaged over windows of at least
+// accel_window seconds to suppress the step count quantization of short segments.
+static void segment_end (segment_t *seg, int n_axis, uint64_t start, uint64_t end, double f)
+{
+    uint_fast8_t idx;
+
+    if(window.start == 0)
+        window.start = start;
+
+    for(idx = 0; idx < n_axis; idx++) {
+        if(seg->step_event_count)
+            window.steps[idx] += (double)seg->n_step * (double)seg->steps[idx] / (double)seg->step_event_count;
+    }
+
+    if((double)(end - window.start) < accel_window * f)
+        return;
+
+    for(idx = 0; idx < n_axis; idx++) {
+
+        axis_t *a = &axis[idx];
+        double rate = window.steps[idx] * f / (double)(end - window.start);
+
+        if(window.prev_start) {
+            // Rates are averages, the time between them is half of each window.
+            double accel = (rate - a->seg_rate) * 2.0 * f / (double)(end - window.prev_start), change = fabs(accel - a->accel);
+            if(fabs(accel) > a->max_accel)
+                a->max_accel = fabs(accel);
+            if(change > a->max_accel_change) {
+                a->max_accel_change = change;
+                a->max_accel_change_time = window.start;
+            }
+            // The previous acceleration was calculated at the start of the previous window.
+            if(a->accel_valid && change * f / (double)(window.start - window.prev_start) > a->max_jerk) {
+                a->max_jerk = change * f / (double)(window.start - window.prev_start);
+                a->max_jerk_time = window.start;
+            }
+            a->accel_valid = true;
+            a->accel = accel;
+        } else {
+            a->accel = 0.0;
+            a->accel_valid = false;
+        }
+
+        if(verbose && window.steps[idx] > 0.0)
+            printf("%12.6f s: %c rate %.1f steps/s, acceleration %.0f steps/s^2\n", (double)window.start / f, axis_letter[idx], rate, a->accel);
+
+        a->seg_rate = rate;
+        window.steps[idx] = 0.0;
+    }
+
+    window.prev_start = window.start;
+    window.start = end;
+}
+
+// Parses a limit per axis from a comma separated list, the last value applies to the remaining axes.
+static void parse_limits (char *s, double *limits)
+{
+    uint_fast8_t idx;
+
+    for(idx = 0; idx < MAX_AXES; idx++) {
+        limits[idx] = strtod(s, &s);
+        if(*s != ',')
+            break;
+        s++;
+    }
+
+    while(++idx < MAX_AXES)
+        limits[idx] = limits[idx - 1];
+}
+
+// Returns the next step record of an event file, false at end of file.
+static bool next_step (FILE *file, unsigned long long *t, unsigned int *step, unsigned int *dir)
+{
+    char line[256];
+    unsigned long cycles;
+
+    while(fgets(line, sizeof(line), file)) {
+        if(line[0] == 'P' && sscanf(line + 1, "%llu %u %u %lu", t, step, dir, &cycles) == 4)
+            return true;
+    }
+
+    return false;
+}
+
+// Compares the step records of two event files, outputs the first difference.
+static bool compare_steps (const char *name, const char *ref_name)
+{
+    FILE *file, *ref;
+    bool ok, more, ref_more;
+    unsigned long events = 0;
+    unsigned long long t = 0, ref_t = 0;
+    unsigned int step = 0, dir = 0, ref_step = 0, ref_dir = 0;
+
+    if((file = fopen(name, "r")) == NULL || (ref = fopen(ref_name, "r")) == NULL) {
+        perror(file ? ref_name : name);
+        if(file)
+            fclose(file);
+        return false;
+    }
+
+    do {
+        more = next_step(file, &t, &step, &dir);
+        ref_more = next_step(ref, &ref_t, &ref_step, &ref_dir);
+        if((ok = more == ref_more && (!more || (t == ref_t && step == ref_step && dir == ref_dir))))
+            events++;
+    } while(ok && more);
+
+    if(!ok) {
+        if(more && ref_more)
+            printf("Step event %lu differs from %s: %llu %u %u, expected %llu %u %u\n", events + 1, ref_name, t, step, dir, ref_t, ref_step, ref_dir);
+        else
+            printf("Step event count differs from %s\n", ref_name);
+    }
+
+    fclose(file);
+    fclose(ref);
+
+    return ok;
+}
+
+int main (int argc, char **argv)
+{
+    FILE *file;
+    char line[256];
+    int opt, n_axis = 0;
+    bool ok = true, check_pos = false;
+    char *reference = NULL;
+    unsigned int max_steps = 0;
+    unsigned long max_segments = 0;
+    double f = 0.0, max_time = 0.0, max_ramp = 0.0, max_jump[MAX_AXES] = {0}, max_accel[MAX_AXES] = {0}, max_accel_change[MAX_AXES] = {0}, max_jerk[MAX_AXES] = {0};
+    int64_t expected[MAX_AXES] = {0};
+    uint64_t time = 0, seg_start = 0;
+    unsigned long segments = 0, blocks = 0, amass_changes = 0, amass_count[8] = {0}, events = 0;
+    unsigned int amass = 0;
+    segment_t seg = {0};
+    uint_fast8_t idx;
+
+    while((opt = getopt(argc, argv, "vw:t:s:j:m:a:k:p:c:r:n:")) != -1) switch(opt) {
+
+        case 'v':
+            verbose = true;
+            break;
+
+        case 'w':
+            accel_window = strtod(optarg, NULL) / 1000.0;
+            break;
+
+        case 't':
+            max_time = strtod(optarg, NULL);
+            break;
+
+        case 's':
+            max_segments = strtoul(optarg, NULL, 10);
+            break;
+
+        case 'j':
+            parse_limits(optarg, max_jump);
+            break;
+
+        case 'm':
+            parse_limits(optarg, max_accel);
+            break;
+
+        case 'a':
+            parse_limits(optarg, max_accel_change);
+            break;
+
+        case 'k':
+            parse_limits(optarg, max_jerk);
+            break;
+
+        case 'p':
+            {
+                char *s = optarg;
+                check_pos = true;
+                for(idx = 0; idx < MAX_AXES && *s; idx++) {
+                    expected[idx] = strtoll(s, &s, 10);
+                    if(*s == ',')
+                        s++;
+                }
+            }
+            break;
+
+        case 'c':
+            reference = optarg;
+            break;
+
+        case 'r':
+            max_ramp = strtod(optarg, NULL);
+            break;
+
+        case 'n':
+            max_steps = (unsigned int)strtoul(optarg, NULL, 10);
+            break;
+
+        default:
+            fprintf(stderr, "Usage: %s [-v] [-w <ms>] [-t <s>] [-s <segments>] [-j <steps/s>,...] [-m <steps/s^2>,...] [-a <steps/s^2>,...] [-k <steps/s^3>,...] [-p <pos>,<pos>,...] [-c <event file>] [-r <us>] [-n <events>] <event file>\n", argv[0]);
+            return EXIT_FAILURE;
+    }
+
+    if(optind >= argc || (file = fopen(argv[optind], "r")) == NULL) {
+        perror(optind < argc ? argv[optind] : "event file");
+        return EXIT_FAILURE;
+    }
+
+    while(fgets(line, sizeof(line), file)) {
+
+        unsigned long long t;
+
+        switch(line[0]) {
+
+            case 'F':
+                sscanf(line + 1, "%lf %d", &f, &n_axis);
+                if(n_axis > MAX_AXES)
+                    n_axis = MAX_AXES;
+                break;
+
+            case 'S':
+                {
+                    int new_block, n;
+                    unsigned int dir;
+                    segment_t next = { .valid = true };
+                    char *s = line + 1;
+
+                    if(sscanf(s, "%llu %d %u %u %lu %u %lu%n", &t, &new_block, &next.n_step, &next.level, &next.cycles, &dir, &next.step_event_count, &n) < 7) {
+                        fprintf(stderr, "Invalid segment record: %s", line);
+                        ok = false;
+                        break;
+                    }
+                    s += n;
+                    for(idx = 0; idx < n_axis; idx++)
+                        next.steps[idx] = strtoul(s, &s, 10);
+
+                    if(seg.valid) {
+                        segment_duration(&seg, t - seg_start, &next);
+                        segment_end(&seg, n_axis, seg_start, t, f);
+                    }
+
+                    for(idx = 0; idx < n_axis; idx++) {
+                        double rate = axis_rate(&next, idx, next.cycles, f), jump = fabs(rate - axis[idx].rate);
+                        if(jump > axis[idx].max_jump) {
+                            axis[idx].max_jump = jump;
+                            axis[idx].max_jump_time = t;
+                        }
+                        axis[idx].rate = rate;
+                    }
+
+                    if(segments && next.level != amass)
+                        amass_changes++;
+                    amass = next.level;
+                    amass_count[next.level & 7]++;
+
+                    if(new_block)
+                        blocks++;
+
+                    if(verbose)
+                        printf("%12.6f s: segment %lu%s, %u events, AMASS %u, period %lu\n", (double)t / f, segments,
+                                new_block ? " (new block)" : "", next.n_step, next.level, next.cycles);
+
+                    seg = next;
+                    seg_start = t;
+                    segments++;
+                }
+                break;
+
+            case 'P':
+                {
+                    unsigned int step, dir;
+                    unsigned long cycles;
+
+                    if(sscanf(line + 1, "%llu %u %u %lu", &t, &step, &dir, &cycles) < 4) {
+                        fprintf(stderr, "Invalid step record: %s", line);
+                        ok = false;
+                        break;
+                    }
+
+                    events++;
+                    time = t;
+
+                    for(idx = 0; idx < n_axis; idx++) {
+
+                        axis_t *a = &axis[idx];
+
+                        // The rate of an interpolated segment changes for each step event.
+                        // Step events output in batches have no segment, only the position is tracked.
+                        a->rate = axis_rate(&seg, idx, cycles, f);
+                        if(a->rate > a->max_rate)
+                            a->max_rate = a->rate;
+
+                        if(!(step & (1 << idx)))
+                            continue;
+
+                        a->steps++;
+                        a->position += (dir & (1 << idx)) ? -1 : 1;
+
+                        if(a->last_pulse && a->rate > 0.0) {
+                            double jitter = fabs((double)(t - a->last_pulse) / f - 1.0 / a->rate);
+                            // Rate changes within acceleration are not jitter, only count intervals within a segment.
+                            if(a->last_pulse >= seg_start) {
+                                if(jitter > a->max_jitter)
+                                    a->max_jitter = jitter;
+                                a->sum_jitter_sqr += jitter * jitter;
+                                a->jitter_count++;
+                            }
+                        }
+                        a->last_pulse = t;
+                    }
+                }
+                break;
+
+            case 'I':
+                if(sscanf(line + 1, "%llu", &t) == 1) {
+                    time = t;
+                    for(idx = 0; idx < n_axis; idx++) {
+                        if(axis[idx].rate > axis[idx].max_jump) {
+                            axis[idx].max_jump = axis[idx].rate;
+                            axis[idx].max_jump_time = t;
+                        }
+                        axis[idx].rate = 0.0;
+                        axis[idx].last_pulse = 0;
+                    }
+                    if(seg.valid)
+                        segment_duration(&seg, t - seg_start, NULL);
+                    seg.valid = false;
+                    memset(&window, 0, sizeof(window));
+                }
+                break;
+        }
+    }
+
+    fclose(file);
+
+    if(f == 0.0 || n_axis == 0) {
+        fputs("Missing header record\n", stderr);
+        return EXIT_FAILURE;
+    }
+
+    printf("Time: %.6f s, step events: %lu, segments: %lu, blocks: %lu\n", (double)time / f, events, segments, blocks);
+    if(max_time > 0.0 && (double)time / f > max_time) {
+        printf("Time exceeds %.3f s\n", max_time);
+        ok = false;
+    }
+    if(max_segments && segments > max_segments) {
+        printf("Segments exceed %lu\n", max_segments);
+        ok = false;
+    }
+    if(segments) {
+        printf("Segment duration: %.1f - %.1f us, in ramps up to %.1f us, step events up to %u\n", (double)durations.min * 1e6 / f,
+                (double)durations.max * 1e6 / f, (double)durations.max_ramp * 1e6 / f, durations.max_steps);
+        if(max_ramp > 0.0 && (double)durations.max_ramp * 1e6 / f > max_ramp) {
+            printf("Ramp segment duration exceeds %.1f us\n", max_ramp);
+            ok = false;
+        }
+        if(max_steps && durations.max_steps > max_steps) {
+            printf("Segment step events exceed %u\n", max_steps);
+            ok = false;
+        }
+    }
+    printf("AMASS level changes: %lu, segments per level:", amass_changes);
+    for(idx = 0; idx < 4; idx++)
+        printf(" %lu", amass_count[idx]);
+    putchar('\n');
+
+    for(idx = 0; idx < n_axis; idx++) {
+
+        axis_t *a = &axis[idx];
+
+        if(a->steps == 0 && !(check_pos && expected[idx]))
+            continue;
+
+        printf("%c: steps %llu, position %lld, max rate %.1f steps/s, max rate change %.1f steps/s at %.6f s, jitter max %.2f us rms %.2f us\n",
+                axis_letter[idx], (unsigned long long)a->steps, (long long)a->position, a->max_rate,
+                 a->max_jump, (double)a->max_jump_time / f, a->max_jitter * 1e6,
+                  a->jitter_count ? sqrt(a->sum_jitter_sqr / (double)a->jitter_count) * 1e6 : 0.0);
+
+        printf("%c: max acceleration %.0f steps/s^2, max acceleration change %.0f steps/s^2 at %.6f s, max jerk %.0f steps/s^3 at %.6f s\n",
+                axis_letter[idx], a->max_accel, a->max_accel_change, (double)a->max_accel_change_time / f, a->max_jerk, (double)a->max_jerk_time / f);
+
+        if(max_accel[idx] > 0.0 && a->max_accel > max_accel[idx]) {
+            printf("%c: acceleration exceeds %.0f steps/s^2\n", axis_letter[idx], max_accel[idx]);
+            ok = false;
+        }
+
+        if(max_accel_change[idx] > 0.0 && a->max_accel_change > max_accel_change[idx]) {
+            printf("%c: acceleration change exceeds %.0f steps/s^2\n", axis_letter[idx], max_accel_change[idx]);
+            ok = false;
+        }
+
+        if(max_jerk[idx] > 0.0 && a->max_jerk > max_jerk[idx]) {
+            printf("%c: jerk exceeds %.0f steps/s^3\n", axis_letter[idx], max_jerk[idx]);
+            ok = false;
+        }
+
+        if(max_jump[idx] > 0.0 && a->max_jump > max_jump[idx]) {
+            printf("%c: rate change exceeds %.1f steps/s\n", axis_letter[idx], max_jump[idx]);
+            ok = false;
+        }
+    }
+
+    if(reference && !compare_steps(argv[optind], reference))
+        ok = false;
+
+    if(check_pos) for(idx = 0; idx < n_axis; idx++) {
+        if(axis[idx].position != expected[idx]) {
+            printf("%c: position %lld, expected %lld\n", axis_letter[idx], (long long)axis[idx].position, (long long)expected[idx]);
+            ok = false;
+        }
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
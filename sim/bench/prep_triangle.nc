@@ -0,0 +1,5 @@
+(Segment prep benchmark, triangle profiles, see CMakeLists.txt)
+$100=100
+$110=6000
+$120=100
+o<prep_triangle> call
@@ -0,0 +1,11 @@
+(Reads and executes the generated stream read benchmark macro 10 times, see CMakeLists.txt)
+o<read> call
+o<read> call
+o<read> call
+o<read> call
+o<read> call
+o<read> call
+o<read> call
+o<read> call
+o<read> call
+o<read> call
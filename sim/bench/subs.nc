@@ -0,0 +1,101 @@
+(Calls the generated subroutine benchmark macro 100 times, see CMakeLists.txt)
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
+o<subs> call
@@ -0,0 +1,149 @@
+/*
+
+  crctest.c - CRC-16 implementation tests and benchmark for the grblHAL host simulator
+
+  Part of grblHAL
+
+  grblHAL is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  grblHAL is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with grblHAL. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  Usage: crc_test [-b <passes>]
+
+  Checks modbus_crc16x() and ccitt_crc16() of the core, as built with the selected CRC_SLICE_BY, against
+  the standard check values and against bitwise reference implementations for all lengths up to 1024 bytes
+  at each start alignment up to 8 bytes. The exit code is nonzero if a CRC does not match.
+
+  -b also outputs the throughput of each CRC over the given number of passes of a 64 KB buffer,
+     calculated in 256 byte chunks, the largest Modbus RTU frame.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../crc.h"
+
+#define MAX_LENGTH 1024
+#define MAX_OFFSET 8
+#define BENCH_SIZE 65536
+#define BENCH_CHUNK 256
+
+// CRC-16/MODBUS, bitwise: reflected polynomial 0xA001, initial value 0xFFFF.
+static uint16_t ref_modbus (const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0xFFFF;
+
+    while(length--) {
+        crc ^= *data++;
+        for(int bit = 0; bit < 8; bit++)
+            crc = crc & 1 ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+
+    return crc;
+}
+
+// CRC-16/XMODEM, bitwise: polynomial 0x1021, initial value 0.
+static uint16_t ref_ccitt (const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0;
+
+    while(length--) {
+        crc ^= (uint16_t)*data++ << 8;
+        for(int bit = 0; bit < 8; bit++)
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+
+    return crc;
+}
+
+static bool check (const char *name, uint16_t crc, uint16_t expected, size_t offset, size_t length)
+{
+    if(crc != expected)
+        fprintf(stderr, "%s: 0x%04X at offset %zu, length %zu, expected 0x%04X\n", name, crc, offset, length, expected);
+
+    return crc == expected;
+}
+
+static double bench (uint16_t (*crc16)(const uint8_t *buf, uint_fast16_t len), const uint8_t *data, unsigned long passes, uint16_t *sum)
+{
+    size_t pos;
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while(passes--) {
+        for(pos = 0; pos < BENCH_SIZE; pos += BENCH_CHUNK)
+            *sum ^= crc16(data + pos, BENCH_CHUNK);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) * 1e-9;
+}
+
+int main (int argc, char **argv)
+{
+    int opt;
+    bool ok = true;
+    unsigned long passes = 0, seed = 1;
+    size_t offset, length;
+    static uint8_t data[BENCH_SIZE];
+
+    while((opt = getopt(argc, argv, "b:")) != -1) switch(opt) {
+
+        case 'b':
+            passes = strtoul(optarg, NULL, 10);
+            break;
+
+        default:
+            fprintf(stderr, "Usage: %s [-b <passes>]\n", argv[0]);
+            return EXIT_FAILURE;
+    }
+
+    ok = check("modbus_crc16x", modbus_crc16x((const uint8_t *)"123456789", 9), 0x4B37, 0, 9) &&
+          check("ccitt_crc16", ccitt_crc16((const uint8_t *)"123456789", 9), 0x31C3, 0, 9);
+
+    for(offset = 0; offset < BENCH_SIZE; offset++) {
+        seed = seed * 1103515245UL + 12345UL;
+        data[offset] = (uint8_t)(seed >> 16);
+    }
+
+    for(offset = 0; ok && offset < MAX_OFFSET; offset++) {
+        for(length = 0; ok && length <= MAX_LENGTH; length++) {
+            ok = check("modbus_crc16x", modbus_crc16x(data + offset, length), ref_modbus(data + offset, length), offset, length) &&
+                  check("ccitt_crc16", ccitt_crc16(data + offset, length), ref_ccitt(data + offset, length), offset, length);
+        }
+    }
+
+    printf("CRC_SLICE_BY %d: %s\n", CRC_SLICE_BY, ok ? "ok" : "failed");
+
+    if(ok && passes) {
+
+        uint16_t sum = 0;
+        double mbytes = (double)passes * BENCH_SIZE / 1e6;
+
+        printf("modbus_crc16x: %.1f MB/s\n", mbytes / bench(modbus_crc16x, data, passes, &sum));
+        printf("ccitt_crc16: %.1f MB/s\n", mbytes / bench(ccitt_crc16, data, passes, &sum));
+
+        if(sum == 0x5A5A) // Keeps the CRCs from being optimized away.
+            putchar('\n');
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,510 @@
+/*
+
+  decoder.c - binary realtime status frame decoder for the grblHAL host simulator
+
+  Part of grblHAL
+
+  grblHAL is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  grblHAL is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with grblHAL. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  Usage: status_decoder [-v] [-n <frames>] [-p <pos>,<pos>,...] [-s <state>] [-m <monitor file>] <output file>
+         status_decoder [-v] -d <full report output file> [-k <report>,<report>,...] <output file>
+
+  Decodes the binary realtime status frames in the output of grbl_sim as a host would, without the core headers.
+  Frames start with STX (0x02) at the start of a line, text lines are skipped. A frame with a bad length,
+  version or CRC fails the decoding.
+
+  -n fails the decoding if less than the given number of frames are found.
+  -p fails the decoding if the position (in steps) of the last frame does not match.
+  -s fails the decoding if the state of the last frame does not match.
+  -m fails the decoding if the monitor file does not contain one text report per frame, or contains a frame.
+     grbl_sim writes realtime reports to the monitor connection when started with -r.
+  -v lists each frame.
+
+  -d checks the text reports of the output file as delta reports instead. Each is merged with the fields kept from
+     earlier reports and compared to the report at the same position in the output of a run without delta reports.
+     Fields with an empty value are removed. The check fails if a report does not match, or if no field was omitted
+     or sent empty.
+  -k lists the numbers of the delta reports, counting from 1, that must be full reports. -v lists each report.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_AXES 8
+#define MAX_FIELDS 32
+#define FRAME_SOF 0x02
+#define FRAME_VERSION 1
+#define FRAME_LENGTH(n_axis) (26 + 4 * (n_axis))
+
+typedef struct {
+    uint16_t state;
+    uint8_t substate;
+    uint8_t wcs;
+    uint8_t n_axis;
+    int32_t position[MAX_AXES];
+    float feed_rate;
+    float rpm;
+    uint8_t override_feed;
+    uint8_t override_rapid;
+    uint8_t override_spindle;
+    uint8_t spindle;
+    uint8_t coolant;
+    uint8_t limits;
+    uint16_t control;
+} status_t;
+
+typedef struct {
+    char state[16];
+    uint_fast8_t n_fields;
+    struct {
+        char key[8];
+        char value[64];
+    } field[MAX_FIELDS];
+} report_t;
+
+// CRC-16/MODBUS, bitwise.
+static uint16_t crc16 (const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0xFFFF;
+
+    while(length--) {
+        crc ^= *data++;
+        for(int bit = 0; bit < 8; bit++)
+            crc = crc & 1 ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+
+    return crc;
+}
+
+static inline size_t min_size (size_t a, size_t b)
+{
+    return a < b ? a : b;
+}
+
+static uint16_t get_u16 (const uint8_t **p)
+{
+    uint16_t value = (*p)[0] | ((*p)[1] << 8);
+
+    *p += 2;
+
+    return value;
+}
+
+static uint32_t get_u32 (const uint8_t **p)
+{
+    uint32_t value = (*p)[0] | ((*p)[1] << 8) | ((*p)[2] << 16) | ((uint32_t)(*p)[3] << 24);
+
+    *p += 4;
+
+    return value;
+}
+
+static float get_float (const uint8_t **p)
+{
+    float value;
+    uint32_t bits = get_u32(p);
+
+    memcpy(&value, &bits, sizeof(float));
+
+    return value;
+}
+
+// Decodes a frame, returns the frame length or 0 if invalid.
+static size_t decode (const uint8_t *frame, size_t available, status_t *status)
+{
+    size_t length;
+    uint_fast8_t idx;
+    const uint8_t *p = frame + 4;
+
+    if(available < 4 || frame[2] != FRAME_VERSION || frame[3] == 0 || frame[3] > MAX_AXES)
+        return 0;
+
+    if((length = frame[1]) != FRAME_LENGTH(frame[3]) || length > available)
+        return 0;
+
+    if(crc16(frame, length - 2) != (frame[length - 2] | (frame[length - 1] << 8)))
+        return 0;
+
+    status->n_axis = frame[3];
+    status->state = get_u16(&p);
+    status->substate = *p++;
+    status->wcs = *p++;
+    for(idx = 0; idx < status->n_axis; idx++)
+        status->position[idx] = (int32_t)get_u32(&p);
+    status->feed_rate = get_float(&p);
+    status->rpm = get_float(&p);
+    status->override_feed = *p++;
+    status->override_rapid = *p++;
+    status->override_spindle = *p++;
+    status->spindle = *p++;
+    status->coolant = *p++;
+    status->limits = *p++;
+    status->control = get_u16(&p);
+
+    return length;
+}
+
+static uint8_t *load (const char *name, size_t *size)
+{
+    FILE *file;
+    uint8_t *data = NULL;
+    long length;
+
+    if((file = fopen(name, "rb")) == NULL) {
+        perror(name);
+        return NULL;
+    }
+
+    if(fseek(file, 0, SEEK_END) == 0 && (length = ftell(file)) >= 0 && fseek(file, 0, SEEK_SET) == 0 &&
+        (data = malloc((size_t)length + 1)) && fread(data, 1, (size_t)length, file) == (size_t)length) {
+        *size = (size_t)length;
+        data[length] = '\0';
+    }
+    else {
+        free(data);
+        data = NULL;
+        fprintf(stderr, "%s: read failed\n", name);
+    }
+
+    fclose(file);
+
+    return data;
+}
+
+// Fields omitted from delta reports when unchanged.
+static bool is_delta_field (const char *key)
+{
+    return !strcmp(key, "MPos") || !strcmp(key, "WPos") || !strcmp(key, "Bf") || !strcmp(key, "Ln") ||
+            !strcmp(key, "F") || !strcmp(key, "FS") || !strcmp(key, "Pn") || !strncmp(key, "SP", 2);
+}
+
+static int report_find (const report_t *report, const char *key)
+{
+    int idx = report->n_fields;
+
+    while(idx--) {
+        if(!strcmp(report->field[idx].key, key))
+            break;
+    }
+
+    return idx;
+}
+
+// Parses the text report at the start of the line, returns the position after it or NULL if no report.
+static const char *report_parse (const char *line, const char *end, report_t *report)
+{
+    const char *s = line + 1, *sep;
+    size_t length;
+
+    if(*line != '<')
+        return NULL;
+
+    memset(report, 0, sizeof(report_t));
+
+    while(s < end && *s != '>' && *s != '\n') {
+
+        for(sep = s; sep < end && *sep != '|' && *sep != '>' && *sep != '\n'; sep++);
+
+        if(s == line + 1) {
+            length = min_size(sep - s, sizeof(report->state) - 1);
+            memcpy(report->state, s, length);
+        } else if(report->n_fields < MAX_FIELDS) {
+            const char *colon = memchr(s, ':', sep - s);
+            size_t key_length = colon ? (size_t)(colon - s) : (size_t)(sep - s);
+            memcpy(report->field[report->n_fields].key, s, min_size(key_length, sizeof(report->field[0].key) - 1));
+            if(colon)
+                memcpy(report->field[report->n_fields].value, colon + 1, min_size(sep - colon - 1, sizeof(report->field[0].value) - 1));
+            report->n_fields++;
+        }
+
+        s = *sep == '|' ? sep + 1 : sep;
+    }
+
+    while(s < end && *s++ != '\n');
+
+    return s;
+}
+
+// Returns the position of the next text report in the data, NULL if none.
+static const char *report_next (const uint8_t *data, size_t size, size_t *pos)
+{
+    while(*pos < size) {
+        const char *line = (const char *)&data[*pos];
+        while(*pos < size && data[(*pos)++] != '\n');
+        if(*line == '<')
+            return line;
+    }
+
+    return NULL;
+}
+
+static bool report_is_keyframe (const char *keyframes, unsigned long report)
+{
+    char *s = (char *)keyframes;
+
+    while(s && *s) {
+        if(strtoul(s, &s, 10) == report)
+            return true;
+        if(*s++ != ',')
+            break;
+    }
+
+    return false;
+}
+
+// Checks the delta reports in the output against the full reports of a run without delta reports.
+static bool check_delta (const char *output, const char *full, const char *keyframes, bool verbose)
+{
+    bool ok = true;
+    uint8_t *delta_data, *full_data;
+    size_t delta_size, full_size, delta_pos = 0, full_pos = 0;
+    const char *delta_line, *full_line;
+    unsigned long reports = 0, omitted = 0, cleared = 0;
+    report_t merged = {0}, received, expected;
+    int idx, i;
+
+    if((delta_data = load(output, &delta_size)) == NULL)
+        return false;
+
+    if((full_data = load(full, &full_size)) == NULL) {
+        free(delta_data);
+        return false;
+    }
+
+    while(ok && (delta_line = report_next(delta_data, delta_size, &delta_pos))) {
+
+        reports++;
+
+        if((full_line = report_next(full_data, full_size, &full_pos)) == NULL) {
+            fprintf(stderr, "Delta report %lu has no full report\n", reports);
+            ok = false;
+            break;
+        }
+
+        report_parse(delta_line, (const char *)delta_data + delta_size, &received);
+        report_parse(full_line, (const char *)full_data + full_size, &expected);
+
+        // Delta fields are kept from earlier reports, other fields are only present when received.
+        for(idx = merged.n_fields - 1; idx >= 0; idx--) {
+            if(!is_delta_field(merged.field[idx].key)) {
+                memmove(&merged.field[idx], &merged.field[idx + 1], (merged.n_fields - idx - 1) * sizeof(merged.field[0]));
+                merged.n_fields--;
+            } else if(report_find(&received, merged.field[idx].key) < 0)
+                omitted++;
+        }
+
+        strcpy(merged.state, received.state);
+
+        for(idx = 0; idx < received.n_fields; idx++) {
+            if((i = report_find(&merged, received.field[idx].key)) < 0 && merged.n_fields < MAX_FIELDS)
+                i = merged.n_fields++;
+            if(i >= 0)
+                merged.field[i] = received.field[idx];
+            if(*received.field[idx].value == '\0' && is_delta_field(received.field[idx].key)) {
+                cleared++;
+                memmove(&merged.field[i], &merged.field[i + 1], (merged.n_fields - i - 1) * sizeof(merged.field[0]));
+                merged.n_fields--;
+            }
+        }
+
+        if(verbose)
+            printf("%lu: %.*s\n", reports, (int)strcspn(delta_line, "\n"), delta_line);
+
+        ok = !strcmp(merged.state, expected.state) && merged.n_fields == expected.n_fields;
+        for(idx = 0; ok && idx < expected.n_fields; idx++)
+            ok = (i = report_find(&merged, expected.field[idx].key)) >= 0 && !strcmp(merged.field[i].value, expected.field[idx].value);
+
+        if(!ok)
+            fprintf(stderr, "Delta report %lu does not match the full report %.*s\n", reports, (int)strcspn(full_line, "\n"), full_line);
+
+        if(ok && report_is_keyframe(keyframes, reports)) {
+            ok = received.n_fields == expected.n_fields;
+            for(idx = 0; ok && idx < expected.n_fields; idx++)
+                ok = (i = report_find(&received, expected.field[idx].key)) >= 0 && !strcmp(received.field[i].value, expected.field[idx].value);
+            if(!ok)
+                fprintf(stderr, "Delta report %lu is not a full report\n", reports);
+        }
+    }
+
+    printf("Delta reports: %lu, fields omitted: %lu, fields sent empty: %lu\n", reports, omitted, cleared);
+
+    if(ok && (reports == 0 || omitted == 0 || cleared == 0)) {
+        fputs("Expected delta reports with omitted fields and fields sent empty\n", stderr);
+        ok = false;
+    }
+
+    free(delta_data);
+    free(full_data);
+
+    return ok;
+}
+
+int main (int argc, char **argv)
+{
+    int opt;
+    bool ok = true, verbose = false, check_pos = false;
+    int64_t expected[MAX_AXES] = {0};
+    long expected_state = -1;
+    unsigned long min_frames = 1, frames = 0, lines = 0, reports = 0;
+    const char *monitor = NULL, *full = NULL, *keyframes = NULL;
+    uint8_t *data;
+    size_t size, pos = 0, length;
+    status_t status = {0};
+    uint_fast8_t idx;
+
+    while((opt = getopt(argc, argv, "vn:p:s:m:d:k:")) != -1) switch(opt) {
+
+        case 'v':
+            verbose = true;
+            break;
+
+        case 'n':
+            min_frames = strtoul(optarg, NULL, 10);
+            break;
+
+        case 'p':
+            {
+                char *s = optarg;
+                check_pos = true;
+                for(idx = 0; idx < MAX_AXES && *s; idx++) {
+                    expected[idx] = strtoll(s, &s, 10);
+                    if(*s == ',')
+                        s++;
+                }
+            }
+            break;
+
+        case 's':
+            expected_state = strtol(optarg, NULL, 0);
+            break;
+
+        case 'm':
+            monitor = optarg;
+            break;
+
+        case 'd':
+            full = optarg;
+            break;
+
+        case 'k':
+            keyframes = optarg;
+            break;
+
+        default:
+            fprintf(stderr, "Usage: %s [-v] [-n <frames>] [-p <pos>,<pos>,...] [-s <state>] [-m <monitor file>] <output file>\n"
+                             "       %s [-v] -d <full report output file> [-k <report>,<report>,...] <output file>\n", argv[0], argv[0]);
+            return EXIT_FAILURE;
+    }
+
+    if(optind >= argc) {
+        fputs("No output file\n", stderr);
+        return EXIT_FAILURE;
+    }
+
+    if(full)
+        return check_delta(argv[optind], full, keyframes, verbose) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if((data = load(argv[optind], &size)) == NULL)
+        return EXIT_FAILURE;
+
+    while(pos < size) {
+
+        if(data[pos] == FRAME_SOF) {
+            if((length = decode(&data[pos], size - pos, &status)) == 0) {
+                fprintf(stderr, "Invalid frame at offset %zu\n", pos);
+                ok = false;
+                break;
+            }
+            frames++;
+            if(verbose) {
+                printf("state %u:%u wcs %u pos", status.state, status.substate, status.wcs);
+                for(idx = 0; idx < status.n_axis; idx++)
+                    printf(" %ld", (long)status.position[idx]);
+                printf(" F %.1f S %.1f ov %u/%u/%u spindle %02X coolant %02X limits %02X control %04X\n",
+                        status.feed_rate, status.rpm, status.override_feed, status.override_rapid, status.override_spindle,
+                        status.spindle, status.coolant, status.limits, status.control);
+            }
+            pos += length;
+        } else {
+            if(data[pos] == '<')
+                reports++;
+            while(pos < size && data[pos++] != '\n');
+            lines++;
+        }
+    }
+
+    printf("Frames: %lu, text lines: %lu, text reports: %lu\n", frames, lines, reports);
+
+    free(data);
+
+    if(ok && frames < min_frames) {
+        fprintf(stderr, "Expected at least %lu frames\n", min_frames);
+        ok = false;
+    }
+
+    if(ok && reports) {
+        fprintf(stderr, "Text reports output with binary reporting enabled\n");
+        ok = false;
+    }
+
+    if(ok && frames && expected_state >= 0 && status.state != expected_state) {
+        fprintf(stderr, "Last state %u, expected %ld\n", status.state, expected_state);
+        ok = false;
+    }
+
+    if(ok && frames && check_pos) {
+        for(idx = 0; idx < status.n_axis; idx++) {
+            if(status.position[idx] != expected[idx]) {
+                fprintf(stderr, "Last position of axis %u is %ld, expected %lld\n", (unsigned)idx, (long)status.position[idx], (long long)expected[idx]);
+                ok = false;
+            }
+        }
+    }
+
+    if(ok && monitor) {
+
+        unsigned long monitor_reports = 0;
+
+        if((data = load(monitor, &size)) == NULL)
+            return EXIT_FAILURE;
+
+        for(pos = 0; pos < size; pos++) {
+            if(data[pos] == FRAME_SOF) {
+                fprintf(stderr, "Frame output to monitor at offset %zu\n", pos);
+                ok = false;
+                break;
+            }
+            if(data[pos] == '<' && (pos == 0 || data[pos - 1] == '\n'))
+                monitor_reports++;
+        }
+
+        free(data);
+
+        printf("Monitor text reports: %lu\n", monitor_reports);
+
+        if(ok && monitor_reports != frames) {
+            fprintf(stderr, "Expected %lu text reports on the monitor\n", frames);
+            ok = false;
+        }
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,666 @@
+/*
+
+  driver.c - host simulator driver for grblHAL, records the step pulse timeline
+
+  Part of grblHAL
+
+  grblHAL is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  grblHAL is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with grblHAL. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  The step timer is simulated: the stepper interrupt is called whenever the simulated time reaches the
+  next timer interrupt, which is scheduled from the last value passed to hal.stepper.cycles_per_tick().
+  Simulated time advances by a fixed slice each time the core polls for realtime commands, and by the
+  delay for blocking calls to hal.delay_ms(). Step segments are thus prepared at a realistic rate
+  relative to their execution.
+
+  Event stream format, one record per line with times in step timer ticks:
+
+    F <f_step_timer> <n_axis>
+    S <time> <new_block> <n_step> <amass_level> <cycles_per_tick> <dir_bits> <step_event_count> <steps>...
+    P <time> <step_bits> <dir_bits> <cycles_per_tick>
+    I <time>
+
+  F is output first, S when the first step event of a segment is output, P for each step event with
+  at least one step pulse and I when the stepper goes idle. The step counts of S records are per step
+  event, with AMASS applied.
+
+  When built with SIM_PREP_PROFILE enabled and linked with --wrap=st_prep_buffer the time spent preparing step
+  segments is measured and reported on exit with the number of segments executed.
+
+  When built with SIM_READ_PROFILE enabled and linked with --wrap=stream_redirect_read each file opened for
+  execution, such as a called macro, is first read to the end through hal.stream.read(). The number of characters
+  read per second is reported on exit.
+
+  When built with STEP_BATCH_SIZE enabled the driver outputs step events in batches as by DMA and no
+  S records are output. The batch being output and a queued batch are copied, each step event is output
+  when the step timer ticks in it have elapsed. Going idle or disabling the steppers while step events
+  are pending is reported as an error, these steps are lost on a controller.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../hal.h"
+#include "../protocol.h"
+#include "../state_machine.h"
+#include "../planner.h"
+#include "../stream_file.h"
+
+#include "simulator.h"
+
+static bool timer_running = false;
+static uint32_t timer_period = 0;
+static uint64_t timer_next = 0;
+static segment_t *current_segment = NULL;
+static uint64_t delay_end;
+static delay_callback_ptr delay_callback = NULL;
+static on_execute_realtime_ptr on_execute_realtime;
+static enqueue_realtime_command_ptr enqueue_realtime_command = protocol_enqueue_realtime_command;
+
+static struct {
+    char data[RX_BUFFER_SIZE];
+    uint_fast16_t head;
+    uint_fast16_t tail;
+    uint64_t next_line;     // Earliest time for the next line to be received.
+    char last;              // Last character received.
+    bool eof;               // Set when all input has been received.
+} rx = {0};
+
+#if SIM_PREP_PROFILE || SIM_READ_PROFILE
+
+static inline double profile_clock (void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+#endif
+
+#if SIM_PREP_PROFILE
+
+static struct {
+    uint64_t calls;         // Number of calls of st_prep_buffer().
+    uint64_t segments;      // Number of segments executed.
+    double time;            // Time spent in st_prep_buffer() (s).
+    double overhead;        // Time of a clock reading, subtracted from each call (s).
+} prep = {0};
+
+void __real_st_prep_buffer (void);
+
+// Called instead of st_prep_buffer() by the core.
+// NOTE: Most calls find the segment buffer full, the simulator should be run with a poll slice
+//       close to the segment time to keep the clock reading overhead low.
+void __wrap_st_prep_buffer (void)
+{
+    double start = profile_clock();
+
+    __real_st_prep_buffer();
+
+    prep.time += profile_clock() - start - prep.overhead;
+    prep.calls++;
+}
+
+// Sets the overhead to the shortest average time of a clock reading over 10 runs of 1000 readings.
+static void prep_calibrate (void)
+{
+    uint_fast16_t run = 10, idx;
+    double start, time;
+
+    prep.overhead = 1.0;
+
+    while(run--) {
+        idx = 1000;
+        start = profile_clock();
+        while(--idx)
+            profile_clock();
+        if((time = (profile_clock() - start) / 1000.0) < prep.overhead)
+            prep.overhead = time;
+    }
+}
+
+#endif
+
+#if SIM_READ_PROFILE
+
+static struct {
+    uint64_t files;         // Number of files read.
+    uint64_t chars;         // Number of characters read.
+    double time;            // Time spent reading (s).
+} rd = {0};
+
+vfs_file_t *__real_stream_redirect_read (char *filename, status_message_ptr status_handler, on_file_end_ptr eof_handler);
+
+// Called instead of stream_redirect_read() by the core. The file is read to the end through hal.stream.read(),
+// then closed and opened again for execution.
+vfs_file_t *__wrap_stream_redirect_read (char *filename, status_message_ptr status_handler, on_file_end_ptr eof_handler)
+{
+    int16_t c;
+    double start;
+    vfs_file_t *file;
+
+    if((file = __real_stream_redirect_read(filename, NULL, NULL))) {
+
+        start = profile_clock();
+
+        while((c = hal.stream.read()) != ASCII_EOF) {
+            if(c != SERIAL_NO_DATA)
+                rd.chars++;
+        }
+
+        rd.time += profile_clock() - start;
+        rd.files++;
+
+        stream_redirect_close(file);
+    }
+
+    return __real_stream_redirect_read(filename, status_handler, eof_handler);
+}
+
+#endif
+
+#if STEP_BATCH_SIZE
+
+static struct {
+    step_batch_t batch[2];  // Batch being output and queued batch.
+    uint_fast8_t out;       // Index of batch being output.
+    uint_fast8_t count;     // Number of batches being output or queued.
+    uint_fast16_t event;    // Index of next step event to output.
+    uint64_t next;          // Time of next step event output.
+    bool request;           // Set when a batch has started output with no batch queued.
+} dma = {0};
+
+static void sim_error (const char *msg)
+{
+    fprintf(stderr, "%.6f s: %s\n", (double)sim.time / (double)sim.f_step_timer, msg);
+    sim.errors++;
+}
+
+// Outputs the next step event or requests the next batch, returns the time of the next action.
+static uint64_t dma_run (void)
+{
+    if(dma.count == 0 || (dma.count == 1 && dma.request)) {
+
+        bool start = dma.count == 0;
+
+        // Called when started, when a batch starts output with no batch queued
+        // and when output of the last batch is complete.
+        dma.request = false;
+        hal.stepper.interrupt_callback();
+
+        if(start && dma.count)
+            dma.next = sim.time + dma.batch[dma.out].event[0].cycles_per_tick;
+
+        if(dma.count == 0 && timer_running) {
+            sim_error("No batch passed when output is complete");
+            return sim.time + sim.f_step_timer / 100000; // Retry after 10 us.
+        }
+
+        return dma.request ? sim.time : dma.next;
+    }
+
+    step_event_t *event = &dma.batch[dma.out].event[dma.event];
+
+    if(event->step_out.bits && sim.events)
+        fprintf(sim.events, "P %llu %u %u %lu\n", (unsigned long long)sim.time, (unsigned int)event->step_out.bits,
+                 (unsigned int)event->dir_out.bits, (unsigned long)event->cycles_per_tick);
+
+    if(++dma.event < dma.batch[dma.out].length)
+        return dma.next = sim.time + dma.batch[dma.out].event[dma.event].cycles_per_tick;
+
+    dma.out ^= 1;
+    dma.event = 0;
+
+    if(--dma.count) {
+        dma.request = true;
+        dma.next = sim.time + dma.batch[dma.out].event[0].cycles_per_tick;
+    }
+
+    return sim.time;
+}
+
+#endif
+
+static void rx_poll (void);
+
+void sim_run (uint64_t ticks)
+{
+    uint64_t end = sim.time + ticks;
+
+    while(timer_running && timer_next <= end) {
+        sim.time = timer_next;
+#if STEP_BATCH_SIZE
+        timer_next = dma_run();
+#else
+        hal.stepper.interrupt_callback();
+        timer_next = sim.time + timer_period;
+#endif
+    }
+
+    sim.time = end;
+
+    if(delay_callback && sim.time >= delay_end) {
+        delay_callback_ptr callback = delay_callback;
+        delay_callback = NULL;
+        callback();
+    }
+}
+
+// Exits when all input has been processed and motion has completed.
+static void sim_execute_realtime (sys_state_t state)
+{
+    on_execute_realtime(state);
+
+    sim_run(sim.slice);
+    rx_poll();
+
+    if(sim.eof && !timer_running && plan_get_current_block() == NULL &&
+        !(state & (STATE_CYCLE|STATE_HOLD|STATE_JOG|STATE_HOMING|STATE_TOOL_CHANGE))) {
+
+        if(sim.events)
+            fclose(sim.events);
+
+        fflush(stdout);
+        fprintf(stderr, "Simulated time: %.3f s, CPU time: %.3f s\n", (double)sim.time / (double)sim.f_step_timer, (double)clock() / (double)CLOCKS_PER_SEC);
+#if SIM_PREP_PROFILE
+        if(prep.segments)
+            fprintf(stderr, "Segment prep: %llu segments, %llu calls, %.3f us per segment, %.0f segments/s\n",
+                     (unsigned long long)prep.segments, (unsigned long long)prep.calls,
+                      prep.time * 1e6 / (double)prep.segments, (double)prep.segments / prep.time);
+#endif
+#if SIM_READ_PROFILE
+        if(rd.chars)
+            fprintf(stderr, "Stream read: %llu characters from %llu files, %.0f characters/s\n",
+                     (unsigned long long)rd.chars, (unsigned long long)rd.files, (double)rd.chars / rd.time);
+#endif
+
+        exit(sim.errors ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+}
+
+// Stream, reads the g-code input and writes responses to stdout.
+
+// Emulates the receive interrupt, moves input to the receive buffer and executes realtime commands.
+// Lines are received no faster than the line interval.
+static void rx_poll (void)
+{
+    int c;
+    uint_fast16_t next;
+
+    while(!rx.eof && sim.time >= rx.next_line && (next = (rx.head + 1) % RX_BUFFER_SIZE) != rx.tail) {
+
+        if((c = fgetc(sim.input)) == EOF) {
+            rx.eof = true;
+            if(rx.last != ASCII_LF) { // Terminate the last line in case it is not.
+                rx.data[rx.head] = ASCII_LF;
+                rx.head = next;
+            }
+        } else if(!enqueue_realtime_command((char)c)) {
+            rx.data[rx.head] = rx.last = (char)c;
+            rx.head = next;
+            if(c == ASCII_LF)
+                rx.next_line = sim.time + sim.line_interval;
+        }
+    }
+}
+
+static int16_t streamGetC (void)
+{
+    int16_t c;
+
+    rx_poll();
+
+    if(rx.tail == rx.head) {
+        sim.eof = rx.eof;
+        return SERIAL_NO_DATA;
+    }
+
+    c = (int16_t)rx.data[rx.tail];
+    rx.tail = (rx.tail + 1) % RX_BUFFER_SIZE;
+
+    return c;
+}
+
+static void streamWriteS (const char *s)
+{
+    if(strstr(s, "error:") || strstr(s, "ALARM:"))
+        sim.errors++;
+
+    fputs(s, stdout);
+}
+
+static void streamWriteN (const char *s, uint16_t length)
+{
+    fwrite(s, 1, length, stdout);
+}
+
+// Report monitor, a connection that only receives output written to all connections.
+
+static void monitorWriteS (const char *s)
+{
+    fputs(s, sim.monitor);
+}
+
+static bool streamPutC (const char c)
+{
+    putchar(c);
+
+    return true;
+}
+
+static uint16_t streamRxFree (void)
+{
+    return (uint16_t)((RX_BUFFER_SIZE - 1) - (rx.head - rx.tail + RX_BUFFER_SIZE) % RX_BUFFER_SIZE);
+}
+
+static void streamRxFlush (void)
+{
+    rx.tail = rx.head;
+}
+
+static void streamRxCancel (void)
+{
+    rx.data[rx.head] = ASCII_CAN;
+    rx.tail = rx.head;
+    rx.head = (rx.head + 1) % RX_BUFFER_SIZE;
+}
+
+static bool streamSuspendInput (bool suspend)
+{
+    return false;
+}
+
+static enqueue_realtime_command_ptr streamSetRtHandler (enqueue_realtime_command_ptr handler)
+{
+    enqueue_realtime_command_ptr prev = enqueue_realtime_command;
+
+    if(handler)
+        enqueue_realtime_command = handler;
+
+    return prev;
+}
+
+static bool streamIsConnected (void)
+{
+    return true;
+}
+
+// Stepper
+
+static void stepperEnable (axes_signals_t enable, bool hold)
+{
+#if STEP_BATCH_SIZE
+    if(dma.count && !enable.bits)
+        sim_error("Steppers disabled while step events are pending");
+#endif
+}
+
+static void stepperWakeUp (void)
+{
+    timer_running = true;
+    timer_period = sim.f_step_timer / 100000; // First interrupt after 10 us.
+    timer_next = sim.time + timer_period;
+}
+
+static void stepperGoIdle (bool clear_signals)
+{
+    if(timer_running && sim.events)
+        fprintf(sim.events, "I %llu\n", (unsigned long long)sim.time);
+
+    timer_running = false;
+    current_segment = NULL;
+
+#if STEP_BATCH_SIZE
+    if(dma.count) {
+        sim_error("Stepper output stopped while step events are pending");
+        dma.count = 0;
+    }
+    dma.request = false;
+#endif
+}
+
+#if STEP_BATCH_SIZE
+
+static void stepperOutputBatch (step_batch_t *batch)
+{
+    if(dma.count == 2)
+        sim_error("Batch passed while two batches are pending");
+    else {
+        memcpy(&dma.batch[(dma.out + dma.count) & 1], batch, sizeof(step_batch_t));
+        if(dma.count++ == 0)
+            dma.event = 0;
+        dma.request = dma.count == 1;
+    }
+}
+
+#endif
+
+static void stepperCyclesPerTick (uint32_t cycles_per_tick)
+{
+    timer_period = cycles_per_tick ? cycles_per_tick : 1;
+}
+
+static void stepperPulseStart (stepper_t *stepper)
+{
+    bool new_segment;
+
+    if((new_segment = stepper->exec_segment && stepper->exec_segment != current_segment)) {
+        current_segment = stepper->exec_segment;
+#if SIM_PREP_PROFILE
+        prep.segments++;
+#endif
+    }
+
+    if(sim.events == NULL)
+        return;
+
+    if(new_segment) {
+
+        uint_fast8_t idx;
+
+        fprintf(sim.events, "S %llu %d %u %u %lu %u %lu", (unsigned long long)sim.time, stepper->new_block,
+                 (unsigned int)current_segment->n_step, (unsigned int)stepper->amass_level, (unsigned long)timer_period,
+                  (unsigned int)stepper->dir_out.bits, (unsigned long)stepper->step_event_count);
+
+        for(idx = 0; idx < N_AXIS; idx++)
+            fprintf(sim.events, " %lu", (unsigned long)stepper->steps.value[idx]);
+
+        fputc('\n', sim.events);
+    }
+
+    if(stepper->step_out.bits)
+        fprintf(sim.events, "P %llu %u %u %lu\n", (unsigned long long)sim.time, (unsigned int)stepper->step_out.bits,
+                 (unsigned int)stepper->dir_out.bits, (unsigned long)timer_period);
+}
+
+// Inputs, all signals are inactive.
+
+static void limitsEnable (bool on, axes_signals_t homing_cycle)
+{
+}
+
+static limit_signals_t limitsGetState (void)
+{
+    return (limit_signals_t){0};
+}
+
+static control_signals_t systemGetState (void)
+{
+    return (control_signals_t){0};
+}
+
+// Coolant
+
+static coolant_state_t coolant_state = {0};
+
+static void coolantSetState (coolant_state_t mode)
+{
+    coolant_state = mode;
+}
+
+static coolant_state_t coolantGetState (void)
+{
+    return coolant_state;
+}
+
+// Timing
+
+static void driver_delay (uint32_t ms, delay_callback_ptr callback)
+{
+    if(callback) {
+        if(ms) {
+            delay_end = sim.time + (uint64_t)ms * sim.f_step_timer / 1000;
+            delay_callback = callback;
+        } else
+            callback();
+    } else if(ms)
+        sim_run((uint64_t)ms * sim.f_step_timer / 1000);
+    else
+        delay_callback = NULL;
+}
+
+static uint32_t getElapsedTicks (void)
+{
+    return (uint32_t)(sim.time * 1000 / sim.f_step_timer);
+}
+
+static uint64_t getElapsedMicros (void)
+{
+    return sim.time * 1000000 / sim.f_step_timer;
+}
+
+static void bitsSetAtomic (volatile uint_fast16_t *ptr, uint_fast16_t bits)
+{
+    *ptr |= bits;
+}
+
+static uint_fast16_t bitsClearAtomic (volatile uint_fast16_t *ptr, uint_fast16_t bits)
+{
+    uint_fast16_t prev = *ptr;
+
+    *ptr &= ~bits;
+
+    return prev;
+}
+
+static uint_fast16_t valueSetAtomic (volatile uint_fast16_t *ptr, uint_fast16_t value)
+{
+    uint_fast16_t prev = *ptr;
+
+    *ptr = value;
+
+    return prev;
+}
+
+static void settings_changed (settings_t *settings, settings_changed_flags_t changed)
+{
+}
+
+static bool driver_setup (settings_t *settings)
+{
+    return settings->version.id == SETTINGS_VERSION;
+}
+
+bool driver_init (void)
+{
+    static const io_stream_t stream = {
+        .type = StreamType_Serial,
+        .is_connected = streamIsConnected,
+        .read = streamGetC,
+        .write = streamWriteS,
+        .write_all = streamWriteS,
+        .write_n = streamWriteN,
+        .write_char = streamPutC,
+        .get_rx_buffer_free = streamRxFree,
+        .reset_read_buffer = streamRxFlush,
+        .cancel_read_buffer = streamRxCancel,
+        .suspend_read = streamSuspendInput,
+        .set_enqueue_rt_handler = streamSetRtHandler
+    };
+
+    static const io_stream_t monitor = {
+        .type = StreamType_Serial,
+        .instance = 1,
+        .is_connected = streamIsConnected,
+        .read = streamGetC,
+        .write = monitorWriteS,
+        .write_all = monitorWriteS,
+        .get_rx_buffer_free = streamRxFree,
+        .reset_read_buffer = streamRxFlush,
+        .cancel_read_buffer = streamRxCancel,
+        .suspend_read = streamSuspendInput,
+        .set_enqueue_rt_handler = streamSetRtHandler
+    };
+
+    hal.info = "Simulator";
+    hal.driver_version = "250601";
+    hal.driver_setup = driver_setup;
+    hal.settings_changed = settings_changed;
+    hal.f_step_timer = sim.f_step_timer;
+    hal.f_mcu = sim.f_step_timer / 1000000;
+    hal.rx_buffer_size = RX_BUFFER_SIZE;
+    hal.delay_ms = driver_delay;
+    hal.get_elapsed_ticks = getElapsedTicks;
+    hal.get_micros = getElapsedMicros;
+
+    hal.set_bits_atomic = bitsSetAtomic;
+    hal.clear_bits_atomic = bitsClearAtomic;
+    hal.set_value_atomic = valueSetAtomic;
+
+    hal.stepper.wake_up = stepperWakeUp;
+    hal.stepper.go_idle = stepperGoIdle;
+    hal.stepper.enable = stepperEnable;
+    hal.stepper.cycles_per_tick = stepperCyclesPerTick;
+    hal.stepper.pulse_start = stepperPulseStart;
+#if STEP_BATCH_SIZE
+    hal.stepper.output_batch = stepperOutputBatch;
+#endif
+
+    hal.limits.enable = limitsEnable;
+    hal.limits.get_state = limitsGetState;
+
+    hal.control.get_state = systemGetState;
+
+    hal.coolant.set_state = coolantSetState;
+    hal.coolant.get_state = coolantGetState;
+
+    hal.driver_cap.amass_level = 3;
+    hal.driver_cap.step_pulse_delay = On;
+
+    // The monitor is connected first so that it is kept as a secondary connection.
+    if(sim.monitor)
+        stream_connect(&monitor);
+
+    stream_connect(&stream);
+
+    if(sim.root && !hostfs_mount(sim.root))
+        return false;
+
+    on_execute_realtime = grbl.on_execute_realtime;
+    grbl.on_execute_realtime = sim_execute_realtime;
+
+    if(sim.events)
+        fprintf(sim.events, "F %lu %d\n", (unsigned long)sim.f_step_timer, N_AXIS);
+
+#if SIM_PREP_PROFILE
+    prep_calibrate();
+#endif
+
+    return hal.version == HAL_VERSION;
+}
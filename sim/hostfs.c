@@ -0,0 +1,158 @@
+/*
+
+  hostfs.c - host directory file system for the grblHAL host simulator
+
+  Part of grblHAL
+
+  grblHAL is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  grblHAL is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with grblHAL. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  Mounts a host directory as the root file system, read only. Files are accessed with stdio,
+  so macros and programs in the directory can be called from g-code as on a controller with an SD card.
+  File names are matched case insensitively as on a FAT formatted card, the core uppercases macro names.
+*/
+
+#include "../hal.h"
+#include "../vfs.h"
+
+#include <dirent.h>
+#include <strings.h>
+#include <sys/stat.h> // After vfs.h, st_mtime may be defined as a macro.
+
+#include "simulator.h"
+
+#define hostfs_file(file) (*(FILE **)&(file)->handle)
+
+static char root[256];
+
+// Returns the host path of a file, the last path component is matched case insensitively if not found as is.
+static char *host_path (char *path, size_t size, const char *filename)
+{
+    DIR *dir;
+    char *name;
+    struct stat st;
+    struct dirent *entry;
+
+    if(snprintf(path, size, "%s/%s", root, *filename == '/' ? filename + 1 : filename) >= (int)size)
+        return NULL;
+
+    if(stat(path, &st) && (name = strrchr(path, '/'))) {
+
+        *name = '\0';
+
+        if((dir = opendir(path))) {
+            while((entry = readdir(dir)) && strcasecmp(entry->d_name, name + 1));
+            if(entry)
+                strcpy(name + 1, entry->d_name); // Same length.
+            closedir(dir);
+        }
+
+        *name = '/';
+    }
+
+    return path;
+}
+
+static vfs_file_t *fs_open (const char *filename, const char *mode)
+{
+    FILE *handle;
+    vfs_file_t *file;
+    struct stat st;
+    char path[512];
+
+    if(strchr(mode, 'r') == NULL || host_path(path, sizeof(path), filename) == NULL ||
+        stat(path, &st) || !S_ISREG(st.st_mode) || (handle = fopen(path, "rb")) == NULL)
+        return NULL;
+
+    if((file = malloc(sizeof(vfs_file_t) + sizeof(FILE *))) == NULL) {
+        fclose(handle);
+        return NULL;
+    }
+
+    file->size = (size_t)st.st_size;
+    hostfs_file(file) = handle;
+
+    return file;
+}
+
+static void fs_close (vfs_file_t *file)
+{
+    fclose(hostfs_file(file));
+    free(file);
+}
+
+static size_t fs_read (void *buffer, size_t size, size_t count, vfs_file_t *file)
+{
+    return fread(buffer, size, count, hostfs_file(file));
+}
+
+static size_t fs_write (const void *buffer, size_t size, size_t count, vfs_file_t *file)
+{
+    return 0;
+}
+
+static size_t fs_tell (vfs_file_t *file)
+{
+    return (size_t)ftell(hostfs_file(file));
+}
+
+static int fs_seek (vfs_file_t *file, size_t offset)
+{
+    return fseek(hostfs_file(file), (long)offset, SEEK_SET);
+}
+
+static bool fs_eof (vfs_file_t *file)
+{
+    return !!feof(hostfs_file(file));
+}
+
+static int fs_stat (const char *filename, vfs_stat_t *st)
+{
+    struct stat hst;
+    char path[512];
+
+    if(host_path(path, sizeof(path), filename) == NULL || stat(path, &hst))
+        return -1;
+
+    memset(st, 0, sizeof(vfs_stat_t));
+    st->st_size = (size_t)hst.st_size;
+    st->st_mode.directory = S_ISDIR(hst.st_mode);
+    st->st_mode.read_only = true;
+
+    return 0;
+}
+
+bool hostfs_mount (const char *dir)
+{
+    static const vfs_t fs = {
+        .fs_name = "host",
+        .fopen = fs_open,
+        .fclose = fs_close,
+        .fread = fs_read,
+        .fwrite = fs_write,
+        .ftell = fs_tell,
+        .fseek = fs_seek,
+        .feof = fs_eof,
+        .fstat = fs_stat
+    };
+
+    if(strlen(dir) >= sizeof(root))
+        return false;
+
+    strcpy(root, dir);
+
+    return vfs_mount("/", &fs, (vfs_st_mode_t){ .directory = true, .read_only = true });
+}
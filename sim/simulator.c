@@ -0,0 +1,113 @@
+/*
+
+  simulator.c - host simulator for grblHAL step generation
+
+  Part of grblHAL
+
+  grblHAL is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  grblHAL is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with grblHAL. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  Usage: grbl_sim [-t <step timer Hz>] [-s <poll slice us>] [-l <line interval us>] [-e <event file>] [-d <directory>] [-o <output file>] [-r <monitor file>] [<g-code file>]
+
+  G-code is read from the file or stdin, responses are written to stdout. The exit code is nonzero
+  if any error or alarm was reported. The line interval emulates a sender streaming lines at a limited rate.
+  The directory is mounted as the root file system, macros and programs in it can be called from g-code.
+  Responses may be written to an output file instead, -r connects a report monitor that receives output
+  written to all connections, such as realtime reports, to the monitor file.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../grbllib.h"
+
+#include "simulator.h"
+
+sim_t sim = {
+    .f_step_timer = 20000000
+};
+
+int main (int argc, char **argv)
+{
+    int opt;
+    uint32_t slice_us = 10, line_us = 0;
+
+    sim.input = stdin;
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    while((opt = getopt(argc, argv, "t:s:l:e:d:o:r:")) != -1) switch(opt) {
+
+        case 't':
+            sim.f_step_timer = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+
+        case 's':
+            slice_us = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+
+        case 'l':
+            line_us = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+
+        case 'd':
+            sim.root = optarg;
+            break;
+
+        case 'e':
+            if((sim.events = fopen(optarg, "w")) == NULL) {
+                perror(optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+
+        case 'o':
+            if(freopen(optarg, "wb", stdout) == NULL) {
+                perror(optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+
+        case 'r':
+            if((sim.monitor = fopen(optarg, "w")) == NULL) {
+                perror(optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+
+        default:
+            fprintf(stderr, "Usage: %s [-t <step timer Hz>] [-s <poll slice us>] [-l <line interval us>] [-e <event file>] [-d <directory>] [-o <output file>] [-r <monitor file>] [<g-code file>]\n", argv[0]);
+            return EXIT_FAILURE;
+    }
+
+    if(optind < argc && (sim.input = fopen(argv[optind], "r")) == NULL) {
+        perror(argv[optind]);
+        return EXIT_FAILURE;
+    }
+
+    if(sim.f_step_timer < 1000000 || slice_us == 0) {
+        fputs("Step timer frequency must be at least 1 MHz and the poll slice nonzero\n", stderr);
+        return EXIT_FAILURE;
+    }
+
+    sim.slice = (uint32_t)((uint64_t)slice_us * sim.f_step_timer / 1000000);
+    sim.line_interval = (uint32_t)((uint64_t)line_us * sim.f_step_timer / 1000000);
+
+    grbl_enter();
+
+    return EXIT_FAILURE; // grbl_enter() does not return, the driver exits when done.
+}
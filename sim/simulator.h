@@ -0,0 +1,50 @@
+/*
+
+  simulator.h - host simulator for grblHAL step generation
+
+  Part of grblHAL
+
+  grblHAL is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  grblHAL is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with grblHAL. If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _SIMULATOR_H_
+#define _SIMULATOR_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    FILE *input;            // G-code input.
+    FILE *events;           // Step event stream output, NULL if not recorded.
+    FILE *monitor;          // Output of the report monitor connection, NULL if not connected.
+    const char *root;       // Host directory mounted as the root file system, NULL if none.
+    uint32_t f_step_timer;  // Step timer frequency (Hz).
+    uint32_t slice;         // Simulated time per foreground realtime poll (step timer ticks).
+    uint32_t line_interval; // Minimum time between input lines (step timer ticks).
+    uint64_t time;          // Simulated time since start (step timer ticks).
+    uint32_t errors;        // Number of error and alarm responses output.
+    bool eof;               // Set when all input has been read.
+} sim_t;
+
+extern sim_t sim;
+
+// Advances simulated time, running the stepper interrupt when the step timer is running.
+void sim_run (uint64_t ticks);
+
+// Mounts a host directory as the root file system.
+bool hostfs_mount (const char *dir);
+
+#endif
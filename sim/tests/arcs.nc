@@ -0,0 +1,11 @@
+(Arcs and a full circle, ends at the origin)
+$110=3000
+$111=3000
+$120=500
+$121=500
+G21 G90 G94 G17
+G1 X5 F1500
+G2 X10 Y0 I2.5 J0 F1500
+G3 X5 Y0 I-2.5 J0
+G2 X5 Y0 I3 J0 F2000
+G1 X0 Y0
@@ -0,0 +1,11 @@
+(Two full circles of 200 mm radius with a fine arc tolerance, ends at the origin)
+$110=6000
+$111=6000
+$120=20
+$121=20
+$12=0.001
+G21 G90 G94 G17
+G1 X200 F6000
+G2 X200 Y0 I-200 J0
+G2 X200 Y0 I-200 J0
+G1 X0
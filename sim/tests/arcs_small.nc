@@ -0,0 +1,12 @@
+(Circles of 2 and 1 mm radius, ends at the origin)
+$110=6000
+$111=6000
+$120=500
+$121=500
+G21 G90 G94 G17
+G1 X2 F3000
+G2 X2 Y0 I-2 J0
+G2 X2 Y0 I-2 J0
+G3 X2 Y0 I-1 J0
+G3 X2 Y0 I-1 J0
+G1 X0
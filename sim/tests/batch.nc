@@ -0,0 +1,22 @@
+(Straight moves and arcs with the steppers disabled when idle, ends at the origin)
+$1=0
+$110=3000
+$111=3000
+$112=1000
+$120=500
+$121=500
+$122=200
+G21 G90 G94
+G0 X5 Y3
+G1 X10 Y-2 Z1 F2000
+G1 X0 Y0 F1200
+G4 P0.05
+G1 X2 F300
+G1 X2.5 F2500
+G1 X8 Y1 F2500
+G1 X0 Y0 Z0 F2500
+G1 X5 F1500
+G2 X10 Y0 I2.5 J0 F1500
+G3 X5 Y0 I-2.5 J0
+G2 X5 Y0 I3 J0 F2000
+G1 X0 Y0
@@ -0,0 +1,13 @@
+(Binary realtime reports are enabled by the 0x8D byte on the next line, reports are requested by the lines after the moves)
+
+G21 G90 G94
+G1 X10 F600
+?
+G1 Y5
+?
+G1 X4 Y-2
+?
+?
+?
+?
+?
@@ -0,0 +1,48 @@
+(Zigzag of short moves with 90 degree corners as output by CAM, ends at the origin)
+$110=6000
+$111=6000
+$120=500
+$121=500
+G21 G90 G94
+G1 X0 Y0 F3000
+X1 Y1
+X2 Y0
+X3 Y1
+X4 Y0
+X5 Y1
+X6 Y0
+X7 Y1
+X8 Y0
+X9 Y1
+X10 Y0
+X11 Y1
+X12 Y0
+X13 Y1
+X14 Y0
+X15 Y1
+X16 Y0
+X17 Y1
+X18 Y0
+X19 Y1
+X20 Y0
+X21 Y1
+X22 Y0
+X23 Y1
+X24 Y0
+X25 Y1
+X26 Y0
+X27 Y1
+X28 Y0
+X29 Y1
+X30 Y0
+X31 Y1
+X32 Y0
+X33 Y1
+X34 Y0
+X35 Y1
+X36 Y0
+X37 Y1
+X38 Y0
+X39 Y1
+X40 Y0
+G1 X0 Y0
@@ -0,0 +1,8 @@
+(Straight X moves cruising at a low and a high step rate, ends at the origin)
+$110=30000
+$120=5000
+G21 G90 G94
+G1 X50 F1200
+G1 X0
+G1 X200 F28800
+G1 X0
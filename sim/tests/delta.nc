@@ -0,0 +1,43 @@
+(Delta realtime reports, requested by the lines after the move. The 0x87 byte requests a full report)
+G21 G90 G94
+N10 G1 X10 F600
+?
+?
+?
+?
+?
+?
+?
+?
+?
+?
+
+?
+?
+?
+?
+?
+?
+?
+?
+?
+?
+?
+?
+?
+?
+?
+?
+?
+?
+?
+?
+?
+?
+?
+?
+?
+?
+?
+?
+?
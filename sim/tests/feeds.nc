@@ -0,0 +1,13 @@
+(Feed rate changes between X moves, the ramps have to keep to the configured jerk, ends at the origin)
+$110=6000
+$120=500
+$800=5000
+G1 X20 F2500
+X40 F4500
+X60 F3000
+X80 F4000
+X100 F2500
+X105 F4500
+X110 F3500
+X112 F5000
+G1 X0 F6000
@@ -0,0 +1,26 @@
+(Zigzags reversing the light X axis, then the heavy Y axis, ends at the origin)
+$110=6000
+$111=6000
+$120=2000
+$121=200
+$800=50000
+$801=2000
+G21 G90 G94
+G1 X0 Y0 F3000
+X5 Y0.5
+X0 Y1
+X5 Y1.5
+X0 Y2
+X5 Y2.5
+X0 Y3
+X5 Y3.5
+X0 Y4
+X0.5 Y0
+X1 Y4
+X1.5 Y0
+X2 Y4
+X2.5 Y0
+X3 Y4
+X3.5 Y0
+X4 Y4
+X0 Y0
@@ -0,0 +1,37 @@
+(Feed and rapid overrides changed while blocks are buffered, ends at the origin)
+$110=6000
+$120=1000
+G21 G91
+G1 X2 F4000
+G1 X2 F4000
+G1 X2 F4000
+G1 X2 F4000
+G1 X2 F4000
+G1 X2 F4000
+G1 X2 F4000
+G0 X2
+G1 X2 F4000
+G1 X2 F4000
+G1 X2 F4000
+G1 X2 F4000
+G1 X2 F4000
+G1 X2 F4000
+G1 X2 F4000
+G0 X2
+G1 X2 F4000
+G1 X2 F4000
+G1 X2 F4000
+G1 X2 F4000
+G1 X2 F4000
+G1 X2 F4000
+G1 X2 F4000
+G0 X2
+G1 X2 F4000
+G1 X2 F4000
+G1 X2 F4000
+G1 X2 F4000
+G1 X2 F4000
+G1 X2 F4000
+G1 X2 F4000
+G0 X2
+G90 G1 X0 F5000
@@ -0,0 +1,8 @@
+(Straight X moves accelerating to and decelerating from the feed rate, ends at the origin)
+$110=6000
+$120=200
+G21 G90 G94
+G1 X30 F6000
+G1 X0
+G1 X10 F1200
+G1 X0
@@ -0,0 +1,7 @@
+(X move extended while accelerating, the profile is recomputed mid ramp, ends at the origin)
+$110=6000
+$120=500
+$800=5000
+G1 X50 F6000
+G1 X100
+G1 X0
@@ -0,0 +1,11 @@
+(Cubic and quadratic splines at 200% feed override, the chord rates are limited by the curvature. Ends at the origin)
+$110=20000
+$111=20000
+$120=500
+$121=500
+G21 G90 G17 G94
+G1 X0 Y0 F6000
+G5 X20 Y0 I0 J20 P0 Q20
+G5.1 X0 Y0 I-10 J-20
+G5 X20 Y0 I0 J20 P0 Q20
+G5.1 X0 Y0 I-10 J-20
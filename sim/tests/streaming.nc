@@ -0,0 +1,65 @@
+(Short relative X moves streamed slower than they are executed, the tail block is replanned while it is executed. Ends at the origin)
+$110=6000
+$120=200
+G21 G91
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G1 X3 F6000
+G90 G1 X0
@@ -39,6 +39,14 @@
 #define DT_SEGMENT (1.0f / (ACCELERATION_TICKS_PER_SECOND * 60.0f)) // min/segment
 #define REQ_MM_INCREMENT_SCALAR 1.25f
 
+#if CRUISE_SEGMENT_MULTIPLIER > 1
+  #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+    #define CRUISE_SEGMENT_MAX_STEPS ((float)(0xFFFF >> MAX_AMASS_LEVEL))
+  #else
+    #define CRUISE_SEGMENT_MAX_STEPS 65535.0f
+  #endif
+#endif
+
 typedef union {
     uint8_t flags;
     struct {
@@ -50,6 +58,10 @@ typedef union {
     };
 } prep_flags_t;
 
+#if STEP_BATCH_SIZE && SPINDLE_SYNC_ENABLE
+#error "Spindle synchronized motion is not supported with batched step output!"
+#endif
+
 static bool stepping = false;
 
 // Holds the planner block Bresenham algorithm execution data for the segments in the segment
@@ -69,6 +81,16 @@ DCRAM static segment_t segment_buffer[SEGMENT_BUFFER_SIZE];
 // Stepper ISR data struct. Contains the running data for the main stepper ISR.
 static stepper_t st = {};
 
+#if ENABLE_SEGMENT_RATE_INTERPOLATION
+static int32_t cycles_interpolated; // Step timer ticks per step of the segment being executed, in 1/256 ticks.
+#endif
+
+#if STEP_BATCH_SIZE
+static step_batch_t step_batches[2];    // Double buffered batches of step events for the driver to output.
+static step_batch_t *step_batch = NULL; // Batch being filled, step pulses are added to it instead of output when set.
+static bool batch_passed = false;       // Set when a batch has been passed to the driver that may still be output.
+#endif
+
 #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
 typedef struct {
     uint32_t level_1;
@@ -89,11 +111,6 @@ static float cycles_per_min;
 // Step segment ring buffer pointers
 static volatile segment_t *segment_buffer_tail, *segment_buffer_head;
 
-#if ENABLE_JERK_ACCELERATION
-// Static storage for acceleration value of last computed segment.
-static float last_segment_accel = 0.0f;
-#endif
-
 // Pointers for the step segment being prepped from the planner buffer. Accessed only by the
 // main program. Pointers may be planning segments or planner blocks ahead of what being executed.
 static plan_block_t *pl_block;     // Pointer to the planner block being prepped
@@ -121,6 +138,7 @@ typedef struct {
     float current_speed;    // Current speed at the end of the segment buffer (mm/min)
     float maximum_speed;    // Maximum speed of executing block. Not always nominal speed. (mm/min)
     float exit_speed;       // Exit speed of executing block (mm/min)
+    float exit_speed_sqr;   // Square of exit speed, used to avoid recomputing exit_speed (mm/min)^2
 #ifdef KINEMATICS_API
     float rate_multiplier;  // Rate multiplier of executing block.
 #endif
@@ -130,6 +148,31 @@ typedef struct {
     float target_feed;      //
     float inv_feedrate;     // Used by PWM laser mode to speed up segment calculations.
     float current_spindle_rpm;
+#if CRUISE_SEGMENT_MULTIPLIER > 1
+    float dt_cruise;        // Segment time when cruising (min)
+#endif
+#if ENABLE_JERK_ACCELERATION
+    struct {
+        float time;         // Time elapsed since start of ramp (min)
+        float duration;     // Ramp duration (min)
+        float distance;     // Ramp distance (mm)
+        float start_time;   // Duration of the jerk phase at start of ramp (min)
+        float end_time;     // Duration of the jerk phase at end of ramp (min)
+        float start_jerk;   // Jerk of the start phase, signed (mm/min^3)
+        float end_jerk;     // Jerk of the end phase, signed (mm/min^3)
+        float start_accel;  // Acceleration at start of ramp, signed (mm/min^2)
+        float accel;        // Acceleration of the constant acceleration phase, signed (mm/min^2)
+        float start_speed;  // Speed at start of ramp (mm/min)
+        float accel_speed;  // Speed at start of the constant acceleration phase (mm/min)
+        float accel_mm;     // Distance at start of the constant acceleration phase (mm)
+        float end_speed;    // Speed at end of ramp (mm/min)
+        float start_mm;     // Ramp start measured from end of block (mm)
+    } scurve;               // S-curve of the current acceleration or deceleration ramp
+#endif
+#if ENABLE_NATIVE_ARCS
+    int32_t arc_position[N_AXIS];   // Arc position at the end of the last prepped segment (steps)
+    bool arc_block_used;            // True when a segment has been prepped from the current stepper block
+#endif
 } st_prep_t;
 
 //! \endcond
@@ -138,6 +181,297 @@ DCRAM static st_prep_t prep;
 
 extern void gc_output_message (char *message);
 
+#if ENABLE_JERK_ACCELERATION
+
+// Sets the ramp phases for the given acceleration and jerk magnitudes and returns the ramp distance.
+static float scurve_set_phases (float accel, float jerk)
+{
+    float delta_speed, accel_time;
+
+    if(prep.scurve.end_speed < prep.scurve.start_speed)
+        accel = -accel;
+
+    prep.scurve.accel = accel;
+    prep.scurve.start_time = fabsf(accel - prep.scurve.start_accel) / jerk;
+    prep.scurve.start_jerk = prep.scurve.start_time > 0.0f ? (accel - prep.scurve.start_accel) / prep.scurve.start_time : 0.0f;
+    prep.scurve.end_time = fabsf(accel) / jerk;
+    prep.scurve.end_jerk = prep.scurve.end_time > 0.0f ? accel / prep.scurve.end_time : 0.0f;
+
+    prep.scurve.accel_speed = prep.scurve.start_speed + 0.5f * (prep.scurve.start_accel + accel) * prep.scurve.start_time;
+    prep.scurve.accel_mm = prep.scurve.start_time * (prep.scurve.start_speed + prep.scurve.start_time * (2.0f * prep.scurve.start_accel + accel) / 6.0f);
+
+    delta_speed = prep.scurve.end_speed - 0.5f * accel * prep.scurve.end_time - prep.scurve.accel_speed;
+    accel_time = max(delta_speed / accel, 0.0f);
+
+    prep.scurve.duration = prep.scurve.start_time + accel_time + prep.scurve.end_time;
+
+    return prep.scurve.accel_mm + accel_time * (prep.scurve.accel_speed + 0.5f * delta_speed) +
+            prep.scurve.end_time * (prep.scurve.end_speed - accel * prep.scurve.end_time / 6.0f);
+}
+
+// Returns the jerk needed for the speed change to leave room for a constant acceleration phase.
+static inline float scurve_jerk (float accel, float start_accel, float delta_speed, float jerk_min)
+{
+    return max(jerk_min, (accel * accel - 0.5f * start_accel * start_accel) / delta_speed);
+}
+
+/* Sets up a jerk limited S-curve ramp from the start speed and acceleration to the end speed, ending
+   at zero acceleration. The ramp covers the same distance as the trapezoidal ramp computed from the
+   effective block acceleration used by the planner, so the planned entry and exit speeds are met
+   without any speed discontinuity. The start acceleration is nonzero when the ramp replaces a ramp
+   in progress, e.g. when the profile is recomputed because the planner has updated the block or
+   on a feed hold, and carries the acceleration over so it is continuous.
+   The ramp has three phases: changing acceleration from the start acceleration, constant acceleration
+   and decreasing acceleration, the first and last limited by the block jerk. The constant acceleration
+   is the lowest that covers the ramp distance.
+   NOTE: Short ramps, or ramps starting with an acceleration that cannot be ramped down within the
+         speed change, may require a higher jerk than the block jerk to keep the acceleration within
+         the block max acceleration.
+   NOTE: The search takes 24 iterations of scurve_set_phases(), each with three float divisions.
+         On targets without a FPU these are software routines, in the order of 100 cycles each,
+         and the search may then take tens of microseconds. It is run once per ramp. */
+static void scurve_init (float start_speed, float end_speed, float start_accel, float start_mm, float end_mm)
+{
+    bool accelerate = end_speed > start_speed;
+    float delta_speed = fabsf(end_speed - start_speed), distance = start_mm - end_mm, jerk_min, accel, jerk, lo, hi;
+    uint_fast8_t iterations = 24;
+
+    prep.scurve.time = 0.0f;
+    prep.scurve.start_speed = prep.scurve.accel_speed = start_speed;
+    prep.scurve.end_speed = end_speed;
+    prep.scurve.start_mm = start_mm;
+    prep.scurve.distance = distance;
+
+    prep.scurve.start_time = prep.scurve.end_time = prep.scurve.accel_mm = 0.0f;
+    prep.scurve.start_jerk = prep.scurve.end_jerk = prep.scurve.start_accel = prep.scurve.accel = 0.0f;
+
+    if(distance <= 0.0f || start_speed + end_speed <= 0.0f) {
+        prep.scurve.duration = 0.0f;
+        return;
+    }
+
+    if(delta_speed == 0.0f) { // Constant speed.
+        prep.scurve.duration = distance / start_speed;
+        return;
+    }
+
+    // Start acceleration in the direction of the speed change.
+    if(!accelerate)
+        start_accel = -start_accel;
+
+    // The lowest jerk that ramps down the start acceleration well within the speed change,
+    // or that does not decelerate to a standstill at the start of an acceleration ramp.
+    jerk_min = pl_block->jerk;
+    if(start_accel > 0.0f)
+        jerk_min = max(jerk_min, start_accel * start_accel / delta_speed);
+    else if(start_accel < 0.0f && accelerate) {
+        if(start_speed > 0.0f)
+            jerk_min = max(jerk_min, 0.5f * start_accel * start_accel / start_speed);
+        else
+            start_accel = 0.0f;
+    }
+
+    prep.scurve.start_accel = accelerate ? start_accel : -start_accel;
+
+    accel = pl_block->max_acceleration;
+    jerk = scurve_jerk(accel, start_accel, delta_speed, jerk_min);
+
+    if(scurve_set_phases(accel, jerk) <= distance) {
+        // Find the lowest acceleration that covers the ramp distance, the distance decreases with increasing acceleration.
+        lo = 0.0f;
+        hi = accel;
+        do {
+            accel = 0.5f * (lo + hi);
+            if(scurve_set_phases(accel, scurve_jerk(accel, start_accel, delta_speed, jerk_min)) > distance)
+                lo = accel;
+            else
+                hi = accel;
+        } while(--iterations);
+        accel = hi;
+        jerk = scurve_jerk(accel, start_accel, delta_speed, jerk_min);
+    } else {
+        // Max acceleration does not cover the ramp distance, find the jerk that does.
+        // The distance decreases with increasing jerk, the search is over its inverse.
+        lo = 0.0f;
+        hi = 1.0f / jerk;
+        do {
+            if(scurve_set_phases(accel, 2.0f / (lo + hi)) > distance)
+                hi = 0.5f * (lo + hi);
+            else
+                lo = 0.5f * (lo + hi);
+        } while(--iterations);
+        jerk = 1.0f / (lo > 0.0f ? lo : hi);
+    }
+
+    scurve_set_phases(accel, jerk);
+}
+
+// Returns the shortest distance of a ramp between the given speeds, starting and ending at zero acceleration,
+// at the block jerk and max acceleration.
+static float scurve_ramp_mm (float speed_a, float speed_b)
+{
+    float delta_speed = fabsf(speed_b - speed_a), accel = pl_block->max_acceleration;
+
+    return 0.5f * (speed_a + speed_b) * (delta_speed * pl_block->jerk < accel * accel
+                                          ? 2.0f * sqrtf(delta_speed / pl_block->jerk)
+                                          : delta_speed / accel + accel / pl_block->jerk);
+}
+
+/* Computes the profile of a block from its entry, nominal and exit speeds with jerk limited ramps at the
+   block jerk and max acceleration, as planned by the planner. A ramp that cannot reach the nominal speed
+   within the block gets the highest peak speed the block length allows, found by bisection, and is
+   followed by a short cruise.
+   NOTE: If the block is too short for a ramp between its entry and exit speeds, e.g. after a feed hold
+         or override change, the profile is a single ramp and the S-curve needs a higher jerk than the
+         block jerk, see scurve_init(). */
+static void scurve_profile (float nominal_speed)
+{
+    float accel_mm, decel_mm, lo, hi, speed;
+    uint_fast8_t iterations = 12;
+
+    if(scurve_ramp_mm(prep.current_speed, prep.exit_speed) >= pl_block->millimeters) {
+        if(prep.exit_speed > prep.current_speed) { // Acceleration-only type
+            prep.accelerate_until = prep.decelerate_after = 0.0f;
+            prep.maximum_speed = prep.exit_speed;
+        } else // Deceleration-only type
+            prep.ramp_type = Ramp_Decel;
+        return;
+    }
+
+    lo = max(prep.current_speed, prep.exit_speed);
+    hi = max(nominal_speed, lo);
+    accel_mm = scurve_ramp_mm(prep.current_speed, hi);
+    decel_mm = scurve_ramp_mm(hi, prep.exit_speed);
+
+    if(accel_mm + decel_mm > pl_block->millimeters) { // Triangle type, find the peak speed.
+        do {
+            speed = 0.5f * (lo + hi);
+            if(scurve_ramp_mm(prep.current_speed, speed) + scurve_ramp_mm(speed, prep.exit_speed) > pl_block->millimeters)
+                hi = speed;
+            else
+                lo = speed;
+        } while(--iterations);
+        hi = lo;
+        accel_mm = scurve_ramp_mm(prep.current_speed, hi);
+        decel_mm = scurve_ramp_mm(hi, prep.exit_speed);
+    }
+
+    prep.maximum_speed = hi;
+    prep.accelerate_until = pl_block->millimeters - accel_mm;
+    prep.decelerate_after = decel_mm;
+    if(prep.current_speed == hi)
+        prep.ramp_type = Ramp_Cruise;
+}
+
+// Returns distance traveled from ramp start at the given time into the ramp and sets the speed at that time.
+static float scurve_distance (float time, float *speed)
+{
+    float t, distance;
+
+    if(time <= prep.scurve.start_time) {
+        // Changing acceleration from the start acceleration.
+        *speed = prep.scurve.start_speed + time * (prep.scurve.start_accel + 0.5f * prep.scurve.start_jerk * time);
+        distance = time * (prep.scurve.start_speed + time * (0.5f * prep.scurve.start_accel + prep.scurve.start_jerk * time / 6.0f));
+    } else if((t = prep.scurve.duration - time) <= prep.scurve.end_time) {
+        // Decreasing acceleration, computed backwards from ramp end.
+        *speed = prep.scurve.end_speed - 0.5f * prep.scurve.end_jerk * t * t;
+        distance = prep.scurve.distance - t * (prep.scurve.end_speed - prep.scurve.end_jerk * t * t / 6.0f);
+    } else {
+        // Constant acceleration.
+        t = time - prep.scurve.start_time;
+        *speed = prep.scurve.accel_speed + prep.scurve.accel * t;
+        distance = prep.scurve.accel_mm + t * (prep.scurve.accel_speed + 0.5f * prep.scurve.accel * t);
+    }
+
+    return distance;
+}
+
+// Returns the acceleration at the current time into the ramp, zero when not in a ramp.
+static float scurve_acceleration (void)
+{
+    float t;
+
+    if(prep.ramp_type == Ramp_Cruise || prep.scurve.time >= prep.scurve.duration)
+        return 0.0f;
+
+    if(prep.scurve.time <= prep.scurve.start_time)
+        return prep.scurve.start_accel + prep.scurve.start_jerk * prep.scurve.time;
+
+    if((t = prep.scurve.duration - prep.scurve.time) <= prep.scurve.end_time)
+        return prep.scurve.end_jerk * t;
+
+    return prep.scurve.accel;
+}
+
+#endif // ENABLE_JERK_ACCELERATION
+
+#if ENABLE_NATIVE_ARCS
+
+// Computes the position in absolute steps on the arc at the given distance from its end.
+static void arc_get_position (plan_arc_t *arc, float mm_remaining, int32_t *position)
+{
+    if(mm_remaining <= 0.0f)
+        memcpy(position, arc->target_steps, sizeof(arc->target_steps));
+    else {
+        uint_fast8_t idx = N_AXIS;
+        float fraction = 1.0f - mm_remaining / arc->millimeters, angle = arc->angular_travel * fraction;
+        float cos_a = cosf(angle), sin_a = sinf(angle);
+
+        do {
+            idx--;
+            position[idx] = arc->start_steps[idx] + lroundf((float)(arc->target_steps[idx] - arc->start_steps[idx]) * fraction);
+        } while(idx);
+
+        position[arc->axis_0] = lroundf((arc->center[0] + arc->radius_vec[0] * cos_a - arc->radius_vec[1] * sin_a) * settings.axis[arc->axis_0].steps_per_mm);
+        position[arc->axis_1] = lroundf((arc->center[1] + arc->radius_vec[0] * sin_a + arc->radius_vec[1] * cos_a) * settings.axis[arc->axis_1].steps_per_mm);
+    }
+}
+
+// Sets up the Bresenham data for an arc segment from the current arc position to the given position.
+// Each arc segment is executed as a line, a new stepper block is used when the current is referenced
+// by previously prepped segments.
+static st_block_t *arc_prep_block (int32_t *position, uint32_t step_event_count)
+{
+    int32_t delta;
+    uint_fast8_t idx = N_AXIS;
+
+    if(prep.arc_block_used) {
+        st_block_t *block = st_prep_block->next;
+        memcpy(&block->steps, &st_prep_block->steps, sizeof(st_block_t) - offsetof(st_block_t, steps));
+        block->message = NULL;
+        block->output_commands = NULL;
+        st_prep_block = block;
+    }
+
+    prep.arc_block_used = true;
+
+    do {
+        idx--;
+        delta = position[idx] - prep.arc_position[idx];
+      #ifndef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+        st_prep_block->steps.value[idx] = labs(delta) << 1;
+      #else
+        st_prep_block->steps.value[idx] = labs(delta) << MAX_AMASS_LEVEL;
+      #endif
+        if(delta < 0)
+            st_prep_block->direction.bits |= bit(idx);
+        else if(delta)
+            st_prep_block->direction.bits &= ~bit(idx);
+    } while(idx);
+
+  #ifndef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+    st_prep_block->step_event_count = step_event_count << 1;
+  #else
+    st_prep_block->step_event_count = step_event_count << MAX_AMASS_LEVEL;
+  #endif
+
+    memcpy(prep.arc_position, position, sizeof(prep.arc_position));
+
+    return st_prep_block;
+}
+
+#endif // ENABLE_NATIVE_ARCS
+
 /*    BLOCK VELOCITY PROFILE DEFINITION
           __________________________
          /|                        |\     _________________         ^
@@ -198,6 +532,9 @@ void st_wake_up (void)
     stepping = true;
     st.dir_out.bits = 0;
     sys.steppers_deenergize = false;
+#if STEP_BATCH_SIZE
+    batch_passed = false;
+#endif
 
     hal.stepper.go_idle(true); // Reset step & dir outputs
     hal.stepper.wake_up();
@@ -411,6 +748,9 @@ ISR_CODE void ISR_FUNC(stepper_driver_interrupt_handler)(void)
             spindle_tracker.stepper_pulse_start = hal.stepper.pulse_start;
             hal.stepper.pulse_start = st_spindle_sync_out;
         }
+#endif
+#if STEP_BATCH_SIZE
+        if(step_batch == NULL)
 #endif
         hal.stepper.pulse_start(&st);
 
@@ -429,8 +769,20 @@ ISR_CODE void ISR_FUNC(stepper_driver_interrupt_handler)(void)
             st.exec_segment = (segment_t *)segment_buffer_tail;
 
             // Initialize step segment timing per step.
-            if(st.exec_segment->cycles_per_tick != cycles_per_tick)
-                hal.stepper.cycles_per_tick((cycles_per_tick = st.exec_segment->cycles_per_tick));
+            if(st.exec_segment->cycles_per_tick != cycles_per_tick) {
+                cycles_per_tick = st.exec_segment->cycles_per_tick;
+#if STEP_BATCH_SIZE
+                if(step_batch == NULL) // Step timing is passed in the step events when batched.
+#endif
+                hal.stepper.cycles_per_tick(cycles_per_tick);
+            }
+#if ENABLE_SEGMENT_RATE_INTERPOLATION
+            // NOTE: cycles_delta is only set for segments with less than 2^23 cycles per tick, see st_prep_buffer().
+            if(st.exec_segment->cycles_delta) {
+                cycles_interpolated = (int32_t)(cycles_per_tick << 8);
+                cycles_per_tick = 0; // Force reload on next segment, the step rate is changed by interpolation.
+            }
+#endif
 
             //  Load number of steps to execute.
             st.step_count = st.exec_segment->n_step; // NOTE: Can sometimes be zero when moving slow.
@@ -529,6 +881,15 @@ ISR_CODE void ISR_FUNC(stepper_driver_interrupt_handler)(void)
             return; // Nothing to do but exit.
         }
     }
+#if ENABLE_SEGMENT_RATE_INTERPOLATION
+    else if(st.exec_segment->cycles_delta) {
+        cycles_interpolated += st.exec_segment->cycles_delta;
+  #if STEP_BATCH_SIZE
+        if(step_batch == NULL)
+  #endif
+        hal.stepper.cycles_per_tick((uint32_t)(cycles_interpolated >> 8));
+    }
+#endif
 
     // Check probing state.
     // Monitors probe pin state and records the system position when detected.
@@ -643,12 +1004,64 @@ ISR_CODE void ISR_FUNC(stepper_driver_interrupt_handler)(void)
     if(sys.flags.is_homing)
         st.step_out.bits &= sys.homing_axis_lock.bits;
 
+#if STEP_BATCH_SIZE
+    if(step_batch) {
+        step_event_t *event = &step_batch->event[step_batch->length++];
+#if ENABLE_SEGMENT_RATE_INTERPOLATION
+        event->cycles_per_tick = st.exec_segment->cycles_delta ? (uint32_t)(cycles_interpolated >> 8) : st.exec_segment->cycles_per_tick;
+#else
+        event->cycles_per_tick = st.exec_segment->cycles_per_tick;
+#endif
+        event->step_out = st.step_out;
+        event->dir_out = st.dir_out;
+    }
+#endif
+
     if(st.step_count == 0 || --st.step_count == 0) {
         // Segment is complete. Advance segment tail pointer.
         segment_buffer_tail = segment_buffer_tail->next;
     }
 }
 
+#if STEP_BATCH_SIZE
+
+/* Stepper interrupt callback for drivers that output step pulses in batches. Fills the next batch with
+   the step events computed by the stepper driver interrupt handler, called once for each step event,
+   and passes it to the driver. When there are no more step events the call following the last batch
+   returns without going idle, the driver calls back again when output of that batch is complete.
+   NOTE: Positions are updated when the step events are computed and thus lead the output by up to a batch.
+*/
+ISR_CODE void ISR_FUNC(stepper_batch_interrupt_handler)(void)
+{
+    static uint_fast8_t idx = 0;
+
+    uint_fast16_t size = sys.flags.is_homing || sys.probing_state == Probing_Active ? 1 : STEP_BATCH_SIZE;
+
+    // Segment buffer empty, wait for the output of the last batch to complete before going idle.
+    if(batch_passed && (st.exec_segment == NULL || st.step_count == 0) && segment_buffer_tail == segment_buffer_head) {
+        batch_passed = false;
+        return;
+    }
+
+    step_batch = &step_batches[idx];
+    step_batch->length = 0;
+
+    do {
+        if(step_batch->length && (st.exec_segment == NULL || st.step_count == 0) && segment_buffer_tail == segment_buffer_head)
+            break; // Segment buffer empty, output the batch before going idle.
+        stepper_driver_interrupt_handler();
+    } while(stepping && step_batch->length < size);
+
+    if((batch_passed = step_batch->length != 0)) {
+        hal.stepper.output_batch(step_batch);
+        idx ^= 1;
+    }
+
+    step_batch = NULL;
+}
+
+#endif
+
 //! \endcond
 
 // Reset and clear stepper subsystem variables
@@ -769,12 +1182,24 @@ void st_parking_restore_buffer (void)
         prep.recalculate.flags = 0;
         prep.recalculate.hold_partial_block = prep.recalculate.velocity_profile = On;
         prep.req_mm_increment = REQ_MM_INCREMENT_SCALAR / prep.steps_per_mm; // Recompute this value.
+#if ENABLE_NATIVE_ARCS
+        prep.arc_block_used = true;
+#endif
     } else
         prep.recalculate.flags = 0;
 
     pl_block = NULL; // Set to reload next block.
 }
 
+// Sets the exit speed of the executing block, the square root is only computed when it has changed.
+static inline void set_exit_speed (float exit_speed_sqr)
+{
+    if(exit_speed_sqr != prep.exit_speed_sqr) {
+        prep.exit_speed_sqr = exit_speed_sqr;
+        prep.exit_speed = exit_speed_sqr > 0.0f ? sqrtf(exit_speed_sqr) : 0.0f;
+    }
+}
+
 /* Prepares step segment buffer. Continuously called from main program.
 
    The segment buffer is an intermediary buffer interface between the execution of steps
@@ -806,8 +1231,15 @@ void st_prep_buffer (void)
             if (pl_block == NULL)
                 return; // No planner blocks. Exit.
 
+#if ENABLE_JERK_ACCELERATION
+            float start_accel = 0.0f; // Acceleration carried over to the first ramp of a recomputed profile.
+#endif
+
             // Check if we need to only recompute the velocity profile or load a new block.
             if (prep.recalculate.velocity_profile) {
+#if ENABLE_JERK_ACCELERATION
+                start_accel = scurve_acceleration();
+#endif
                 if(settings.parking.flags.enabled) {
                     if (prep.recalculate.parking)
                         prep.recalculate.velocity_profile = Off;
@@ -859,16 +1291,22 @@ void st_prep_buffer (void)
                 prep.steps_remaining = pl_block->step_event_count;
                 prep.req_mm_increment = REQ_MM_INCREMENT_SCALAR / prep.steps_per_mm;
                 prep.dt_remainder = prep.target_position = 0.0f; // Reset for new segment block
+#if ENABLE_NATIVE_ARCS
+                if(pl_block->condition.arc_motion) {
+                    prep.arc_block_used = false;
+                    memcpy(prep.arc_position, pl_block->arc.start_steps, sizeof(prep.arc_position));
+                }
+#endif
 #ifdef KINEMATICS_API
                 prep.rate_multiplier = pl_block->rate_multiplier;
 #endif
                 if (sys.step_control.execute_hold || prep.recalculate.decel_override) {
                     // New block loaded mid-hold. Override planner block entry speed to enforce deceleration.
                     prep.current_speed = prep.exit_speed;
-                    pl_block->entry_speed_sqr = prep.exit_speed * prep.exit_speed;
+                    pl_block->entry_speed_sqr = prep.exit_speed_sqr;
                     prep.recalculate.decel_override = Off;
-                } else
-                    prep.current_speed = sqrtf(pl_block->entry_speed_sqr);
+                } else // Entry speed is normally the exit speed of the previous block.
+                    prep.current_speed = pl_block->entry_speed_sqr == prep.exit_speed_sqr ? prep.exit_speed : sqrtf(pl_block->entry_speed_sqr);
 
                 // Setup laser mode variables. RPM rate adjusted motions will always complete a motion with the
                 // spindle off.
@@ -896,27 +1334,26 @@ void st_prep_buffer (void)
                 float decel_dist = pl_block->millimeters - inv_2_accel * pl_block->entry_speed_sqr;
                 if(decel_dist < -0.0001f) {
                     // Deceleration through entire planner block. End of feed hold is not in this block.
-                    prep.exit_speed = sqrtf(pl_block->entry_speed_sqr - 2.0f * pl_block->acceleration * pl_block->millimeters);
+                    set_exit_speed(pl_block->entry_speed_sqr - 2.0f * pl_block->acceleration * pl_block->millimeters);
                 } else {
                     prep.mm_complete = decel_dist < 0.0001f ? 0.0f : decel_dist; // End of feed hold.
-                    prep.exit_speed = 0.0f;
+                    set_exit_speed(0.0f);
                 }
             } else { // [Normal Operation]
                 // Compute or recompute velocity profile parameters of the prepped planner block.
                 prep.ramp_type = Ramp_Accel; // Initialize as acceleration ramp.
                 prep.accelerate_until = pl_block->millimeters;
 
-                float exit_speed_sqr;
-                if (sys.step_control.execute_sys_motion)
-                    prep.exit_speed = exit_speed_sqr = 0.0f; // Enforce stop at end of system motion.
-                else {
-                    exit_speed_sqr = plan_get_exec_block_exit_speed_sqr();
-                    prep.exit_speed = sqrtf(exit_speed_sqr);
-                }
+                float exit_speed_sqr = sys.step_control.execute_sys_motion
+                                        ? 0.0f // Enforce stop at end of system motion.
+                                        : plan_get_exec_block_exit_speed_sqr();
+                set_exit_speed(exit_speed_sqr);
 
                 float nominal_speed = plan_compute_profile_nominal_speed(pl_block);
                 float nominal_speed_sqr = nominal_speed * nominal_speed;
+#if !ENABLE_JERK_ACCELERATION
                 float intersect_distance = 0.5f * (pl_block->millimeters + inv_2_accel * (pl_block->entry_speed_sqr - exit_speed_sqr));
+#endif
 
                 prep.target_feed = nominal_speed;
 
@@ -930,7 +1367,7 @@ void st_prep_buffer (void)
                         // prep.maximum_speed = prep.current_speed;
 
                         // Compute override block exit speed since it doesn't match the planner exit speed.
-                        prep.exit_speed = sqrtf(pl_block->entry_speed_sqr - 2.0f * pl_block->acceleration * pl_block->millimeters);
+                        set_exit_speed(pl_block->entry_speed_sqr - 2.0f * pl_block->acceleration * pl_block->millimeters);
                         prep.recalculate.decel_override = On; // Flag to load next block as deceleration override.
 
                         // TODO: Determine correct handling of parameters in deceleration-only.
@@ -943,7 +1380,12 @@ void st_prep_buffer (void)
                         prep.maximum_speed = nominal_speed;
                         prep.ramp_type = Ramp_DecelOverride;
                     }
-                } else if (intersect_distance > 0.0f) {
+                }
+#if ENABLE_JERK_ACCELERATION
+                else
+                    scurve_profile(nominal_speed);
+#else
+                else if (intersect_distance > 0.0f) {
                     if (intersect_distance < pl_block->millimeters) { // Either trapezoid or triangle types
                         // NOTE: For acceleration-cruise and cruise-only types, following calculation will be 0.0.
                         prep.decelerate_after = inv_2_accel * (nominal_speed_sqr - exit_speed_sqr);
@@ -970,8 +1412,34 @@ void st_prep_buffer (void)
                     // prep.decelerate_after = 0.0f;
                     prep.maximum_speed = prep.exit_speed;
                 }
+#endif
             }
 
+#if CRUISE_SEGMENT_MULTIPLIER > 1
+            // Use longer segments when cruising, limited by the number of steps a segment can hold.
+            prep.dt_cruise = prep.maximum_speed > 0.0f
+                              ? min(DT_SEGMENT * CRUISE_SEGMENT_MULTIPLIER, CRUISE_SEGMENT_MAX_STEPS / (prep.maximum_speed * prep.steps_per_mm))
+                              : DT_SEGMENT;
+#endif
+
+#if ENABLE_JERK_ACCELERATION
+            // Set up the S-curve for the first ramp of the profile, continuing from the current acceleration.
+            switch(prep.ramp_type) {
+
+                case Ramp_Accel:
+                case Ramp_DecelOverride:
+                    scurve_init(prep.current_speed, prep.maximum_speed, start_accel, pl_block->millimeters, prep.accelerate_until);
+                    break;
+
+                case Ramp_Decel:
+                    scurve_init(prep.current_speed, prep.exit_speed, start_accel, pl_block->millimeters, prep.mm_complete);
+                    break;
+
+                default:
+                    break;
+            }
+#endif
+
             if(state_get() != STATE_HOMING)
                 sys.step_control.update_spindle_rpm |= pl_block->spindle.hal->cap.laser; // Force update whenever updating block in laser mode.
 
@@ -1004,17 +1472,24 @@ void st_prep_buffer (void)
           the end of planner block (typical) or mid-block at the end of a forced deceleration,
           such as from a feed hold.
         */
+#if ENABLE_SEGMENT_RATE_INTERPOLATION
+        float start_speed = prep.current_speed; // Speed at start of segment
+#endif
         float dt_max = DT_SEGMENT; // Maximum segment time
+#if CRUISE_SEGMENT_MULTIPLIER > 1
+        bool cruise_extended = false;
+        if(prep.ramp_type == Ramp_Cruise && !(pl_block->spindle.css || pl_block->spindle.state.synchronized ||
+                                               pl_block->condition.arc_motion || sys.step_control.execute_hold)) {
+            if((cruise_extended = prep.dt_cruise > DT_SEGMENT))
+                dt_max = prep.dt_cruise;
+        }
+#endif
         float dt = 0.0f; // Initialize segment time
         float time_var = dt_max; // Time worker variable
         float mm_var; // mm - Distance worker variable
         float speed_var; // Speed worker variable
         float mm_remaining = pl_block->millimeters; // New segment distance from end of block.
         float minimum_mm = mm_remaining - prep.req_mm_increment; // Guarantee at least one step.
-#if ENABLE_JERK_ACCELERATION
-        float time_to_jerk;     // time needed for jerk ramp
-        float jerk_rampdown;    // calculated startpoint of jerk rampdown
-#endif
 
         if (minimum_mm < 0.0f)
             minimum_mm = 0.0f;
@@ -1024,6 +1499,18 @@ void st_prep_buffer (void)
             switch (prep.ramp_type) {
 
                 case Ramp_DecelOverride:
+#if ENABLE_JERK_ACCELERATION
+                    if ((prep.scurve.time + time_var) < prep.scurve.duration) { // Mid-deceleration override ramp.
+                        prep.scurve.time += time_var;
+                        mm_remaining = prep.scurve.start_mm - scurve_distance(prep.scurve.time, &prep.current_speed);
+                    } else {
+                        // Cruise or cruise-deceleration types only for deceleration override.
+                        time_var = prep.scurve.duration - prep.scurve.time;
+                        mm_remaining = prep.accelerate_until;
+                        prep.ramp_type = Ramp_Cruise;
+                        prep.current_speed = prep.maximum_speed;
+                    }
+#else
                     speed_var = pl_block->acceleration * time_var;
                     if ((prep.current_speed - prep.maximum_speed) <= speed_var) {
                         // Cruise or cruise-deceleration types only for deceleration override.
@@ -1035,26 +1522,26 @@ void st_prep_buffer (void)
                         mm_remaining -= time_var * (prep.current_speed - 0.5f * speed_var);
                         prep.current_speed -= speed_var;
                     }
+#endif
                     break;
 
                 case Ramp_Accel:
                     // NOTE: Acceleration ramp only computes during first do-while loop.
 #if ENABLE_JERK_ACCELERATION
-                    time_to_jerk = last_segment_accel / pl_block->jerk;
-                    jerk_rampdown =time_to_jerk * (prep.current_speed + (0.5f * last_segment_accel * time_to_jerk) + (pl_block->jerk * time_to_jerk * time_to_jerk) / 6.0f);  //Distance to 0 acceleration at speed (mm == V(0)*T + 1/2 A0*T^2 + 1/6 J*T^3)
-                    if ((mm_remaining - prep.accelerate_until) > jerk_rampdown) {
-                        //+1.0f to avoid divide by 0 speed, minor effect on jerk ramp
-                        // Check if we are on ramp up or ramp down. Ramp down if distance to end of acceleration is less than distance needed to reach 0 acceleration.
-                        // Then limit acceleration change by jerk up to max acceleration and update for next segment.
-                        // Minimum acceleration jerk per time_var to ensure acceleration completes. Acceleration change at end of ramp is in acceptable jerk range.
-                        last_segment_accel = min(last_segment_accel + pl_block->jerk * time_var, pl_block->max_acceleration);
-                    } else {
-                        last_segment_accel = max(last_segment_accel - pl_block->jerk * time_var, pl_block->jerk * time_var);
+                    if ((prep.scurve.time + time_var) < prep.scurve.duration) { // Acceleration only.
+                        prep.scurve.time += time_var;
+                        mm_remaining = prep.scurve.start_mm - scurve_distance(prep.scurve.time, &prep.current_speed);
+                        break;
                     }
-                    speed_var = last_segment_accel * time_var;
+                    // End of acceleration ramp.
+                    // Acceleration-cruise, acceleration-deceleration ramp junction, or end of block.
+                    time_var = prep.scurve.duration - prep.scurve.time;
+                    mm_remaining = prep.accelerate_until; // NOTE: 0.0 at EOB
+                    prep.current_speed = prep.maximum_speed;
+                    if ((prep.ramp_type = mm_remaining == prep.decelerate_after ? Ramp_Decel : Ramp_Cruise) == Ramp_Decel)
+                        scurve_init(prep.current_speed, prep.exit_speed, 0.0f, mm_remaining, prep.mm_complete);
 #else
                     speed_var = pl_block->acceleration * time_var;
-#endif
                     mm_remaining -= time_var * (prep.current_speed + 0.5f * speed_var);
                     if (mm_remaining < prep.accelerate_until) { // End of acceleration ramp.
                         // Acceleration-cruise, acceleration-deceleration ramp junction, or end of block.
@@ -1062,11 +1549,9 @@ void st_prep_buffer (void)
                         time_var = 2.0f * (pl_block->millimeters - mm_remaining) / (prep.current_speed + prep.maximum_speed);
                         prep.ramp_type = mm_remaining == prep.decelerate_after ? Ramp_Decel : Ramp_Cruise;
                         prep.current_speed = prep.maximum_speed;
-#if ENABLE_JERK_ACCELERATION
-                        last_segment_accel = 0.0f;  // reset acceleration variable to 0 for next accel ramp
-#endif
                     } else // Acceleration only.
                         prep.current_speed += speed_var;
+#endif
                     break;
 
                 case Ramp_Cruise:
@@ -1079,6 +1564,9 @@ void st_prep_buffer (void)
                         time_var = (mm_remaining - prep.decelerate_after) / prep.maximum_speed;
                         mm_remaining = prep.decelerate_after; // NOTE: 0.0 at EOB
                         prep.ramp_type = Ramp_Decel;
+#if ENABLE_JERK_ACCELERATION
+                        scurve_init(prep.current_speed, prep.exit_speed, 0.0f, mm_remaining, prep.mm_complete);
+#endif
                     } else // Cruising only.
                         mm_remaining = mm_var;
                     break;
@@ -1086,20 +1574,18 @@ void st_prep_buffer (void)
                 default: // case Ramp_Decel:
                     // NOTE: mm_var used as a misc worker variable to prevent errors when near zero speed.
 #if ENABLE_JERK_ACCELERATION
-                    time_to_jerk = last_segment_accel / pl_block->jerk;
-                    jerk_rampdown = prep.exit_speed + time_to_jerk * (last_segment_accel - (0.5f * pl_block->jerk * time_to_jerk)); // Speedpoint to start ramping down deceleration. (V = a * t - 1/2 j * t^2)
-                    if (prep.current_speed > jerk_rampdown) {
-                        // Check if we are on ramp up or ramp down. Ramp down if speed is less than speed needed for reaching 0 acceleration.
-                        // Then limit acceleration change by jerk up to max acceleration and update for next segment.
-                        // Minimum acceleration of jerk per time_var to ensure deceleration completes. Acceleration change at end of ramp is in acceptable jerk range.
-                        last_segment_accel = min(last_segment_accel + pl_block->jerk * time_var, pl_block->max_acceleration);
-                    } else {
-                        last_segment_accel = max(last_segment_accel - pl_block->jerk * time_var, pl_block->jerk * time_var);
+                    if ((prep.scurve.time + time_var) < prep.scurve.duration) {
+                        // Compute distance from end of segment to end of block.
+                        mm_var = prep.scurve.start_mm - scurve_distance(prep.scurve.time + time_var, &speed_var); // (mm)
+                        if (mm_var > prep.mm_complete) { // Typical case. In deceleration ramp.
+                            prep.scurve.time += time_var;
+                            mm_remaining = mm_var;
+                            prep.current_speed = speed_var;
+                            break; // Segment complete. Exit switch-case statement. Continue do-while loop.
+                        }
                     }
-                    speed_var = last_segment_accel * time_var; // Used as delta speed (mm/min)
 #else
                     speed_var = pl_block->acceleration * time_var; // Used as delta speed (mm/min)
-#endif
                     if (prep.current_speed > speed_var) { // Check if at or below zero speed.
                         // Compute distance from end of segment to end of block.
                         mm_var = mm_remaining - time_var * (prep.current_speed - 0.5f * speed_var); // (mm)
@@ -1109,15 +1595,24 @@ void st_prep_buffer (void)
                             break; // Segment complete. Exit switch-case statement. Continue do-while loop.
                         }
                     }
+#endif
                     // Otherwise, at end of block or end of forced-deceleration.
+#if ENABLE_JERK_ACCELERATION
+                    time_var = prep.scurve.duration - prep.scurve.time;
+                    prep.scurve.time = prep.scurve.duration;
+#else
                     time_var = 2.0f * (mm_remaining - prep.mm_complete) / (prep.current_speed + prep.exit_speed);
+#endif
                     mm_remaining = prep.mm_complete;
                     prep.current_speed = prep.exit_speed;
-#if ENABLE_JERK_ACCELERATION
-                    last_segment_accel = 0.0f;  // reset acceleration variable to 0 for next accel ramp
-#endif
             }
 
+#if CRUISE_SEGMENT_MULTIPLIER > 1
+            if(cruise_extended && prep.ramp_type != Ramp_Cruise) {
+                cruise_extended = false;
+                dt_max = DT_SEGMENT; // End of cruise, end segment at the ramp junction if past the normal segment time.
+            }
+#endif
             dt += time_var; // Add computed ramp time to total segment time.
 
             if (dt < dt_max)
@@ -1134,6 +1629,31 @@ void st_prep_buffer (void)
 
         } while (mm_remaining > prep.mm_complete); // **Complete** Exit loop. Profile complete.
 
+#if ENABLE_NATIVE_ARCS
+        int32_t arc_position[N_AXIS];
+        uint32_t arc_step_count = 0;
+
+        if(pl_block->condition.arc_motion) {
+
+            uint_fast8_t idx = N_AXIS;
+
+            arc_get_position(&pl_block->arc, mm_remaining, arc_position);
+
+            do {
+                idx--;
+                arc_step_count = max(arc_step_count, (uint32_t)labs(arc_position[idx] - prep.arc_position[idx]));
+            } while(idx);
+
+            // No steps to execute, add the segment time to the next segment. The last segment of the profile is
+            // always output, even without steps, so that the block is executed. End of feed hold is handled below.
+            if(arc_step_count == 0 && mm_remaining > prep.mm_complete && !sys.step_control.execute_hold) {
+                prep.dt_remainder += dt;
+                pl_block->millimeters = mm_remaining;
+                continue;
+            }
+        }
+#endif
+
         /* -----------------------------------------------------------------------------------
            Compute spindle spindle speed for step segment
         */
@@ -1186,6 +1706,13 @@ void st_prep_buffer (void)
         float step_dist_remaining = prep.steps_per_mm * mm_remaining; // Convert mm_remaining to steps
         uint32_t n_steps_remaining = (uint32_t)ceilf(step_dist_remaining); // Round-up current steps remaining
 
+#if ENABLE_NATIVE_ARCS
+        if(pl_block->condition.arc_motion) {
+            // Steps to execute are from the segment end position on the arc, the block step count only tracks progress.
+            prep_segment->n_step = (uint_fast16_t)arc_step_count;
+            step_dist_remaining = (float)n_steps_remaining;
+        } else
+#endif
         prep_segment->n_step = (uint_fast16_t)(prep.steps_remaining - n_steps_remaining); // Compute number of steps to execute.
 
         // Bail if we are at the end of a feed hold and don't have a step to execute.
@@ -1207,7 +1734,16 @@ void st_prep_buffer (void)
         // typically very small and do not adversely effect performance, but ensures that grblHAL
         // outputs the exact acceleration and velocity profiles as computed by the planner.
         dt += prep.dt_remainder; // Apply previous segment partial step execute time
+#if ENABLE_NATIVE_ARCS
+        float inv_rate;
+        if(pl_block->condition.arc_motion) {
+            prep_segment->exec_block = arc_prep_block(arc_position, arc_step_count);
+            inv_rate = arc_step_count ? dt / (float)arc_step_count : dt;
+        } else
+            inv_rate = dt / ((float)prep.steps_remaining - step_dist_remaining); // Compute adjusted step rate inverse
+#else
         float inv_rate = dt / ((float)prep.steps_remaining - step_dist_remaining); // Compute adjusted step rate inverse
+#endif
 
         // Compute timer ticks per step for the prepped segment.
         uint32_t cycles = (uint32_t)ceilf(cycles_per_min * inv_rate); // (cycles/step)
@@ -1231,6 +1767,18 @@ void st_prep_buffer (void)
         }
       #endif
 
+#if ENABLE_SEGMENT_RATE_INTERPOLATION
+        // Ramp the step rate from the segment start to end speed. The start rate is set so that the
+        // average step rate, and thus the segment execution time, is unchanged.
+        prep_segment->cycles_delta = 0;
+        if(prep_segment->n_step > 1 && cycles < (1UL << 23) && !prep_segment->spindle_sync && (start_speed + prep.current_speed) > 0.0f) {
+            float cycles_range = 2.0f * (float)cycles * (start_speed - prep.current_speed) / (start_speed + prep.current_speed);
+            cycles_range = max(min(cycles_range, (float)cycles), -(float)cycles); // Keep the rate between half and twice the average.
+            prep_segment->cycles_delta = (int32_t)(cycles_range * 256.0f / (float)(prep_segment->n_step - 1));
+            cycles = (uint32_t)((float)cycles - 0.5f * cycles_range);
+        }
+#endif
+
         prep_segment->cycles_per_tick = cycles;
         prep_segment->current_rate = prep.current_speed;
         prep_segment->ramp_type = prep.ramp_type;
@@ -67,6 +67,9 @@ typedef struct st_segment {
     struct st_segment *next;            //!< Pointer to next element in cirular list of segments
     st_block_t *exec_block;             //!< Pointer to the block data for the segment
     uint32_t cycles_per_tick;           //!< Step distance traveled per ISR tick, aka step rate.
+#if ENABLE_SEGMENT_RATE_INTERPOLATION
+    int32_t cycles_delta;               //!< Change of cycles_per_tick per step in 1/256 ticks, 0 for a constant step rate.
+#endif
     float current_rate;
     float target_position;              //!< Target position of segment relative to block start, used by spindle sync code
     uint_fast16_t n_step;               //!< Number of step events to be executed for this segment
@@ -80,6 +83,23 @@ typedef struct st_segment {
     spindle_update_rpm_ptr update_rpm;  //!< Valid pointer to spindle.update_rpm() if set spindle speed at the start of the segment execution
 } segment_t;
 
+#if STEP_BATCH_SIZE
+
+//! Step event to be output by drivers outputting step pulses in batches.
+typedef struct {
+    uint32_t cycles_per_tick;           //!< Step timer ticks to wait before outputting the step event.
+    axes_signals_t step_out;            //!< The stepping signals to be output, may be none for AMASS or homing.
+    axes_signals_t dir_out;             //!< The direction signals to be output, must be set before the stepping signals.
+} step_event_t;
+
+//! Batch of step events to be output by drivers outputting step pulses in batches, see \ref STEP_BATCH_SIZE.
+typedef struct {
+    uint_fast16_t length;               //!< Number of step events in the batch.
+    step_event_t event[STEP_BATCH_SIZE];//!< Step events to be output.
+} step_batch_t;
+
+#endif
+
 //! Stepper ISR data struct. Contains the running data for the main stepper ISR.
 typedef struct stepper {
     bool new_block;                 //!< Set to true when a new block is started, might be referenced by driver code for advanced functionality.
@@ -131,6 +151,10 @@ float st_get_realtime_rate (void);
 
 void stepper_driver_interrupt_handler (void);
 
+#if STEP_BATCH_SIZE
+void stepper_batch_interrupt_handler (void);
+#endif
+
 offset_id_t st_get_offset_id (void);
 
 #endif
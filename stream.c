@@ -105,6 +105,21 @@ bool stream_enumerate_streams (stream_enumerate_callback_ptr callback)
     return claimed;
 }
 
+// Enumerates the streams written to by hal.stream.write_all(), stops when the callback returns true.
+bool stream_enumerate_connections (stream_connection_enumerate_callback_ptr callback, void *data)
+{
+    bool done = false;
+    stream_connection_t *connection = connections;
+
+    while(connection && !done) {
+        if(connection->is_up())
+            done = callback(connection->stream, data);
+        connection = connection->next;
+    }
+
+    return done;
+}
+
 // called from stream drivers while tx is blocking, returns false to terminate
 bool stream_tx_blocking (void)
 {
@@ -115,6 +115,27 @@ typedef uint16_t (*get_stream_buffer_count_ptr)(void);
 */
 typedef int16_t (*stream_read_ptr)(void);
 
+/*! \brief Pointer to function for handing over a complete line from a input stream in a single call.
+
+The line is handed over in the stream buffer, the core copies it to its line buffer while filtering it as it does
+ for characters returned by the read handler. This saves a handler call and the buffer handling per character.
+
+On success _line_ is set to point to the first character of the line and _length_ to the number of characters
+ in it, the line terminator(s) are consumed but not included. The line data must remain valid until the next call
+ to any of the stream read handlers.
+The line shall not contain #ASCII_CAN or #ASCII_EOF characters, these must be returned by the read handler.
+
+Implementations shall return \a false if a complete line is not available, e.g. when a partial line has already
+ been read character by character or the line wraps around the end of a buffer, the core will then fall back to
+ the read handler. \a false shall also be returned if the _hal.stream.read_ handler is not the one paired with
+ this function, e.g. when input is suspended during a tool change.
+
+\param line pointer to a \a char pointer that receives the start of the line.
+\param length pointer to a \a size_t variable that receives the number of characters in the line.
+\returns \a true if a complete line was handed over, \a false otherwise.
+*/
+typedef bool (*stream_read_line_ptr)(char **line, size_t *length);
+
 /*! \brief Pointer to function for writing a null terminated string to the output stream.
 \param s pointer to null terminated string.
 
@@ -264,6 +285,7 @@ typedef struct {
     set_baud_rate_ptr set_baud_rate;                        //!< Optional handler for setting the stream baud rate. Required for Modbus support, recommended for Bluetooth support.
     on_linestate_changed_ptr on_linestate_changed;          //!< Optional handler to be called when line state changes. Set by client.
     vfs_file_t *file;                                       //!< File handle, non-null if streaming from a file.
+    stream_read_line_ptr read_line;                         //!< Optional handler for handing over a complete line from the input stream.
 } io_stream_t;
 
 typedef const io_stream_t *(*stream_claim_ptr)(uint32_t baud_rate);
@@ -276,6 +298,7 @@ typedef struct {
 } io_stream_properties_t;
 
 typedef bool (*stream_enumerate_callback_ptr)(io_stream_properties_t const *properties);
+typedef bool (*stream_connection_enumerate_callback_ptr)(const io_stream_t *stream, void *data);
 
 typedef struct io_stream_details {
     uint8_t n_streams;
@@ -355,6 +378,8 @@ void stream_register_streams (io_stream_details_t *details);
 
 bool stream_enumerate_streams (stream_enumerate_callback_ptr callback);
 
+bool stream_enumerate_connections (stream_connection_enumerate_callback_ptr callback, void *data);
+
 bool stream_connect (const io_stream_t *stream);
 
 bool stream_connect_instance (uint8_t instance, uint32_t baud_rate);
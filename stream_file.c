@@ -22,32 +22,69 @@
 #include "hal.h"
 #include "stream_file.h"
 
+#ifndef STREAM_FILE_BUFFER_SIZE
+#define STREAM_FILE_BUFFER_SIZE 256
+#endif
+
 typedef struct rd_stream {
     vfs_file_t *file_new;
     vfs_file_t *file;
     stream_read_ptr read;
+    stream_read_line_ptr read_line;
     stream_type_t type;
     status_message_ptr status_handler;
     on_file_end_ptr eof_handler;
     struct rd_stream *next;
+    size_t buf_offset;  // File position of first character in buffer.
+    size_t buf_len;     // Number of valid characters in buffer.
+    size_t buf_idx;     // Index of next character to return from buffer.
+    char buffer[STREAM_FILE_BUFFER_SIZE];
 } rd_stream_t;
 
-static rd_stream_t *rd_streams = NULL;
+static bool eol_ok = false;
+static rd_stream_t *rd_streams = NULL, *rd_active = NULL;
 static status_message_ptr status_message;
 static on_file_end_ptr on_file_end;
 static on_report_handlers_init_ptr on_report_handlers_init;
 
+static rd_stream_t *get_stream (vfs_file_t *file)
+{
+    rd_stream_t *stream = rd_streams;
+
+    if(stream) do {
+        if(stream->file_new == file)
+            break;
+    } while((stream = stream->next));
+
+    return stream;
+}
+
+// Returns next character from the read-ahead buffer, refills it from the file when empty.
+static inline bool buffer_getc (rd_stream_t *stream, char *c)
+{
+    if(stream->buf_idx == stream->buf_len) {
+        stream->buf_offset += stream->buf_len;
+        stream->buf_idx = 0;
+        if((stream->buf_len = vfs_read(stream->buffer, 1, STREAM_FILE_BUFFER_SIZE, stream->file_new)) == 0)
+            return false;
+    }
+
+    *c = stream->buffer[stream->buf_idx++];
+
+    return true;
+}
+
 // File stream input function.
-// Reads character by character from a file and returns them when
-// requested by the foreground process.
+// Reads character by character from a read-ahead buffer that is refilled
+// in chunks from the file and returns them when requested by the foreground process.
 static int16_t stream_read_file (void)
 {
-    static bool eol_ok = false;
-
     char c;
 
     if(hal.stream.file) {
-        if(vfs_read(&c, 1, 1, hal.stream.file) == 1) {
+        if(rd_active == NULL || rd_active->file_new != hal.stream.file)
+            rd_active = get_stream(hal.stream.file);
+        if(rd_active ? buffer_getc(rd_active, &c) : vfs_read(&c, 1, 1, hal.stream.file) == 1) {
             if(c == ASCII_CR || c == ASCII_LF) {
                 if(eol_ok)
                     return SERIAL_NO_DATA;
@@ -67,6 +104,44 @@ static int16_t stream_read_file (void)
     return (int16_t)c;
 }
 
+// File stream line input function.
+// Hands over the next line in the read-ahead buffer if it is completely contained in it.
+// Empty lines are skipped as in stream_read_file(). Lines containing ASCII_CAN or ASCII_EOF
+// are left to stream_read_file() as these have to be returned to the caller.
+static bool stream_read_file_line (char **line, size_t *length)
+{
+    if(!eol_ok || hal.stream.read != stream_read_file || hal.stream.file == NULL)
+        return false;
+
+    if(rd_active == NULL || rd_active->file_new != hal.stream.file)
+        rd_active = get_stream(hal.stream.file);
+
+    if(rd_active == NULL)
+        return false;
+
+    char *s = rd_active->buffer + rd_active->buf_idx, *end = rd_active->buffer + rd_active->buf_len;
+
+    while(s < end && (*s == ASCII_CR || *s == ASCII_LF))
+        s++;
+
+    rd_active->buf_idx = s - rd_active->buffer;
+
+    *line = s;
+
+    while(s < end) {
+        if(*s == ASCII_CR || *s == ASCII_LF) {
+            *length = s - *line;
+            rd_active->buf_idx = s - rd_active->buffer + 1;
+            return true;
+        }
+        if(*s == ASCII_CAN || *s == ASCII_EOF)
+            break;
+        s++;
+    }
+
+    return false;
+}
+
 static status_code_t onFileEnd (vfs_file_t *file, status_code_t status)
 {
     rd_stream_t *stream;
@@ -134,21 +209,34 @@ bool stream_is_file (void)
 
 vfs_file_t *stream_redirect_read (char *filename, status_message_ptr status_handler, on_file_end_ptr eof_handler)
 {
-    static bool error_handler_ok = false;
-
     vfs_file_t *file;
 
-    if((file = vfs_open(filename, "r"))) {
+    if((file = vfs_open(filename, "r")))
+        file = stream_redirect_read_file(file, status_handler, eof_handler);
+
+    return file;
+}
+
+// Redirect input to an already opened file, the file is closed on failure.
+vfs_file_t *stream_redirect_read_file (vfs_file_t *file, status_message_ptr status_handler, on_file_end_ptr eof_handler)
+{
+    static bool error_handler_ok = false;
+
+    if(file) {
         rd_stream_t *rd_stream, *streams = rd_streams;
         if((rd_stream = malloc(sizeof(rd_stream_t)))) {
             rd_stream->file = hal.stream.file;
             rd_stream->type = hal.stream.type;
             rd_stream->file_new = file;
             rd_stream->read = hal.stream.read;
+            rd_stream->read_line = hal.stream.read_line;
             rd_stream->eof_handler = eof_handler;
             rd_stream->status_handler = status_handler;
             rd_stream->next = NULL;
+            rd_stream->buf_offset = vfs_tell(file);
+            rd_stream->buf_len = rd_stream->buf_idx = 0;
             hal.stream.read = stream_read_file;
+            hal.stream.read_line = stream_read_file_line;
             stream_set_type(StreamType_File, file);
             if(streams == NULL)
                 rd_streams = rd_stream;
@@ -188,14 +276,46 @@ void stream_redirect_close (vfs_file_t *file)
         if(stream->file_new == file) {
             vfs_close(file);
             hal.stream.read = stream->read;
+            hal.stream.read_line = stream->read_line;
             stream_set_type(stream->type, stream->file);
             if(stream == rd_streams)
                 rd_streams = stream->next;
             else
                 prev_stream->next = stream->next;
+            if(stream == rd_active)
+                rd_active = NULL;
             free(stream);
             break;
         }
         prev_stream = stream;
     } while((stream = stream->next));
 }
+
+// Returns the position of the next character to be read from the file,
+// accounting for characters read ahead into the stream buffer.
+size_t stream_file_tell (vfs_file_t *file)
+{
+    rd_stream_t *stream;
+
+    return (stream = get_stream(file)) ? stream->buf_offset + stream->buf_idx : vfs_tell(file);
+}
+
+// Sets the position of the next character to be read from the file.
+// The read-ahead buffer is kept if the new position is within it,
+// typically the case when looping back in short O-word loops.
+int stream_file_seek (vfs_file_t *file, size_t offset)
+{
+    int ret = 0;
+    rd_stream_t *stream;
+
+    if((stream = get_stream(file)) == NULL)
+        ret = vfs_seek(file, offset);
+    else if(offset >= stream->buf_offset && offset <= stream->buf_offset + stream->buf_len)
+        stream->buf_idx = offset - stream->buf_offset;
+    else if((ret = vfs_seek(file, offset)) == 0) {
+        stream->buf_offset = offset;
+        stream->buf_len = stream->buf_idx = 0;
+    }
+
+    return ret;
+}
@@ -28,3 +28,6 @@ bool stream_is_file (void);
 void stream_redirect_close (vfs_file_t *file);
 void stream_set_type (stream_type_t type, vfs_file_t *file);
 vfs_file_t *stream_redirect_read (char *filename, status_message_ptr status_handler, on_file_end_ptr eof_handler);
+vfs_file_t *stream_redirect_read_file (vfs_file_t *file, status_message_ptr status_handler, on_file_end_ptr eof_handler);
+size_t stream_file_tell (vfs_file_t *file);
+int stream_file_seek (vfs_file_t *file, size_t offset);
@@ -271,12 +271,15 @@ vfs_file_t *vfs_open (const char *filename, const char *mode)
 
 void vfs_close (vfs_file_t *file)
 {
+    bool update = file->update;
+    vfs_t *fs = (vfs_t *)file->fs;
+
     vfs_errno = 0;
 
-    ((vfs_t *)(file->fs))->fclose(file);
+    fs->fclose(file); // may free file
 
-    if(file->update && vfs.on_fs_changed)
-        vfs.on_fs_changed((vfs_t *)file->fs);
+    if(update && vfs.on_fs_changed)
+        vfs.on_fs_changed(fs);
 }
 
 size_t vfs_read (void *buffer, size_t size, size_t count, vfs_file_t *file)